@@ -0,0 +1,258 @@
+/*
+ * Copyright 2017. All rights reserved.
+ * Distributed under the terms of the MIT license.
+ *
+ * Author:
+ *	Humdinger, humdingerb@gmail.com
+ */
+#include <parsedate.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <Catalog.h>
+#include <DateTimeFormat.h>
+#include <DurationFormat.h>
+#include <StringList.h>
+#include <TimeFormat.h>
+
+#include "Constants.h"
+#include "OldOutputParser.h"
+
+#undef B_TRANSLATION_CONTEXT
+#define B_TRANSLATION_CONTEXT "ParserBenchmark"
+
+
+OldOutputParser::OldOutputParser(float& noteProgress, BString& noteEta):
+	progress(noteProgress),
+	eta(noteEta)
+{
+	Reset();
+}
+
+
+OldOutputParser::~OldOutputParser()
+{
+}
+
+
+#pragma mark -- Public Methods --
+
+
+int32
+OldOutputParser::ParseBlankLine(BString& text, BString newline)
+{
+	return NOCHANGE;
+}
+
+
+int32
+OldOutputParser::ParseCdrecordLine(BString& text, BString newline,
+	int32 stream)
+{
+	int32 resultNewline;
+	int32 resultText;
+
+	// cdrecord reports errors on stderr, and its progress on stdout
+	if (stream != STDOUT_FILENO) {
+		// does the data not fit on current disc?
+		resultNewline = newline.FindFirst(
+			"cdrecord: WARNING: Data may not fit on current disk.");
+		if (resultNewline != B_ERROR)
+			return SMALLDISC;
+
+		resultNewline = newline.FindFirst(
+			"cdrecord: Data does not fit on current disk.");
+		if (resultNewline != B_ERROR)
+			return SMALLDISC;
+
+		// invalid wavs stopped the burning?
+		resultNewline = newline.FindFirst(
+			"cdrecord: Inappropriate audio coding in");
+		if (resultNewline != B_ERROR)
+			return INVALIDWAV;
+	}
+	if (stream == STDERR_FILENO)
+		return NOCHANGE;
+
+	resultNewline = newline.FindFirst(" MB written (fifo");
+	if (resultNewline != B_ERROR) {
+		// calculate percentage
+		BStringList wordList;
+		newline.Split(" ", true, wordList);
+		float currentSize = atof(wordList.StringAt(2));
+		float targetSize = atof(wordList.StringAt(4));
+		progress = currentSize / targetSize;
+
+		// calculate ETA
+		bigtime_t now = (bigtime_t)real_time_clock_usecs();
+		float speed = ((currentSize - fLastSize) * 1000000.0
+			/ (now - fLastTime)); // MB/s
+		float secondsLeft = (targetSize - currentSize) / speed;
+		fLastTime = now;
+		fLastSize = currentSize;
+
+		BString duration;
+		BDurationFormat formatter;
+		formatter.Format(duration, now, now + ((bigtime_t)secondsLeft * 1000000LL));
+		if (duration == "")
+			eta = B_TRANSLATE("Finished very soon now");
+		else {
+			eta = B_TRANSLATE("Finished in %duration%");
+			eta.ReplaceFirst("%duration%", duration);
+		}
+
+		// print on top of the last line (not if this is the first progress line)
+		resultText = text.FindFirst(" MB written (fifo");
+		if (resultText != B_ERROR) {
+			int32 offset = text.FindLast("\n");
+			if (offset != B_ERROR)
+				text.Remove(offset, text.CountChars() - offset);
+		}
+		text << "\n" << newline;
+		return PERCENT;
+	}
+	return NOCHANGE;
+}
+
+
+int32
+OldOutputParser::ParseIsoinfoLine(BString& text, BString newline)
+{
+	return NOCHANGE;
+}
+
+
+int32
+OldOutputParser::ParseMediainfoLine(int64& size, BString newline)
+{
+	int32 resultNewline;
+	resultNewline = newline.FindFirst("Remaining writable size:");
+	if (resultNewline != B_ERROR) {
+		// blank R/RW: get capacity (reported in KiB!)
+		BStringList wordList;
+		newline.Split(" ", true, wordList);
+		size = atoll(wordList.StringAt(3)); // size in KiB
+	}
+	resultNewline = newline.FindFirst("Last session leadout start address:");
+	if (resultNewline != B_ERROR) {
+		// CD/DVD: get data size (reported in 2K blocks!)
+		BStringList wordList;
+		newline.Split(" ", true, wordList);
+		size = atoll(wordList.StringAt(5)) * 2;
+	}
+	return NOCHANGE;
+}
+
+
+int32
+OldOutputParser::ParseMkisofsLine(BString& text, BString newline,
+	int32 stream)
+{
+	int32 resultNewline;
+	int32 resultText;
+	// mkisofs reports its progress on stderr
+	if (stream == STDOUT_FILENO)
+		return NOCHANGE;
+
+	// detect progress of makeisofs
+	resultNewline = newline.FindFirst("done, estimate finish");
+	if (resultNewline != B_ERROR) {
+		// get the percentage
+		BStringList percentList;
+		newline.Split("%", true, percentList);
+		progress = atof(percentList.StringAt(0)) / 100;
+
+		// get the ETA
+		BString when;
+		int32 charCount = newline.FindFirst("finish");
+		newline.CopyInto(when, charCount + 6, newline.CountChars());
+
+		const char* dateformat("A B d H:M:S Y");
+		set_dateformats(&dateformat);
+		bigtime_t finishTime = parsedate(when, -1);
+		bigtime_t now = (bigtime_t)real_time_clock_usecs();
+
+		BString duration;
+		BDurationFormat formatter;
+		// add 1 sec, otherwise the last second of the progress isn't shown...
+		formatter.Format(duration, now - 1000000LL, finishTime * 1000000LL);
+
+		if (duration == "")
+			eta = B_TRANSLATE("Finished very soon now");
+		else {
+			eta = B_TRANSLATE("Finished in %duration%");
+			eta.ReplaceFirst("%duration%", duration);
+		}
+		// print on top of the last line (not if this is the first progress line)
+		resultText = text.FindFirst("done, estimate finish");
+		if (resultText != B_ERROR) {
+			int32 offset = text.FindLast("\n");
+			if (offset != B_ERROR)
+				text.Remove(offset, text.CountChars() - offset);
+		}
+		text << "\n" << newline;
+		return PERCENT;
+	}
+	return NOCHANGE;
+}
+
+
+int32
+OldOutputParser::ParseReadcdLine(BString& text, BString newline)
+{
+	int32 resultNewline;
+	int32 resultText;
+
+	resultNewline = newline.FindFirst("Capacity: ");
+	if (resultNewline != B_ERROR) {
+		BStringList wordList;
+		newline.Split(" ", true, wordList);
+		fCapacity = atof(wordList.StringAt(1));
+		return NOCHANGE;
+	}
+	resultNewline = newline.FindFirst("addr:");
+	if (resultNewline != B_ERROR) {
+		// calculate percentage
+		BStringList wordList;
+		newline.Split(" ", true, wordList);
+		float currentSize = atof(wordList.StringAt(1));
+		progress = currentSize / fCapacity;
+
+		// calculate ETA
+		bigtime_t now = (bigtime_t)real_time_clock_usecs();
+		float speed = ((currentSize - fLastSize) * 1000000.0
+			/ (now - fLastTime)); // MB/s
+		float secondsLeft = (fCapacity - currentSize) / speed;
+		fLastTime = now;
+		fLastSize = currentSize;
+
+		BString duration;
+		BDurationFormat formatter;
+		formatter.Format(duration, now, now + ((bigtime_t)secondsLeft * 1000000LL));
+		if (duration == "")
+			eta = B_TRANSLATE("Finished very soon now");
+		else {
+			eta = B_TRANSLATE("Finished in %duration%");
+			eta.ReplaceFirst("%duration%", duration);
+		}
+
+		// print on top of the last line (not if this is the first progress line)
+		resultText = text.FindFirst("addr:");
+		if (resultText != B_ERROR) {
+			int32 offset = text.FindLast("\n");
+			if (offset != B_ERROR)
+				text.Remove(offset, text.CountChars() - offset);
+		}
+		text << "\n" << newline;
+		return PERCENT;
+	}
+	return NOCHANGE;
+}
+
+
+void
+OldOutputParser::Reset()
+{
+	fLastTime = (bigtime_t)real_time_clock_usecs() - 1000000LL; // now - 1 sec
+	fLastSize = 0;
+}
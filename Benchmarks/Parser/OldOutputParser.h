@@ -0,0 +1,45 @@
+/*
+ * Copyright 2017. All rights reserved.
+ * Distributed under the terms of the MIT license.
+ *
+ * Author:
+ *	Humdinger, humdingerb@gmail.com
+ */
+#ifndef OLDOUTPUTPARSER_H
+#define OLDOUTPUTPARSER_H
+
+#include <String.h>
+#include <SupportDefs.h>
+
+
+// OutputParser as it was before it matched the messages of a line in one
+// pass, with a BString::FindFirst() for each message. Only its debug output
+// was taken out, so the benchmark doesn't measure the terminal.
+class OldOutputParser {
+public:
+				OldOutputParser(float& noteProgress, BString& noteEta);
+	virtual		~OldOutputParser();
+
+	int32		ParseBlankLine(BString& text, BString newline);
+	// "stream" is the stream the line came from, STDOUT_FILENO or
+	// STDERR_FILENO, or -1 if unknown. Only the messages a command
+	// actually writes to that stream are looked for.
+	int32		ParseCdrecordLine(BString& text, BString newline,
+					int32 stream = -1);
+	int32		ParseIsoinfoLine(BString& text, BString newline);
+	int32		ParseMediainfoLine(int64& size, BString newline);
+	int32		ParseMkisofsLine(BString& text, BString newline,
+					int32 stream = -1);
+	int32		ParseReadcdLine(BString& text, BString newline);
+	void		Reset();
+
+private:
+	float&		progress;
+	BString& 	eta;
+
+	bigtime_t	fLastTime;
+	float		fLastSize;
+	float		fCapacity;
+};
+
+#endif // OLDOUTPUTPARSER_H
@@ -0,0 +1,290 @@
+/*
+ * Copyright 2026, BurnItNow Team. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+// Replays transcripts of cdrecord, mkisofs and readcd through OutputParser as
+// it was before it used a PatternMatcher, and as it is now, and tells how
+// long each took per line. The matching is also timed on its own.
+//
+//	ParserBenchmark [-r <repeats>] <transcript>...
+//
+// A transcript has a line of output on each line, after the number of the
+// stream it was written to and a space, "1 " for stdout and "2 " for stderr.
+// The start of its file name tells which tool wrote it: cdrecord, media-info,
+// mkisofs or readcd. Those in "transcripts" are synthetic, see ReadMe.md.
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include <OS.h>
+#include <String.h>
+
+#include "Constants.h"
+#include "OldOutputParser.h"
+#include "OutputParser.h"
+#include "PatternMatcher.h"
+
+
+enum {
+	kCdrecord = 0,
+	kMediainfo,
+	kMkisofs,
+	kReadcd
+};
+
+// The parser's own matchers are timed, and their patterns searched for one
+// by one
+static const struct {
+	const char*				name;
+	const PatternMatcher&	(*matcher)();
+} kTools[] = {
+	{ "cdrecord", OutputParser::CdrecordMatcher },
+	{ "media-info", OutputParser::MediainfoMatcher },
+	{ "mkisofs", OutputParser::MkisofsMatcher },
+	{ "readcd", OutputParser::ReadcdMatcher }
+};
+
+
+struct Transcript {
+	BString				name;
+	int32				tool;
+	std::vector<BString> lines;
+	std::vector<int32>	streams;
+};
+
+
+static bool
+load_transcript(const char* path, Transcript& transcript)
+{
+	const char* leaf = strrchr(path, '/');
+	leaf = leaf != NULL ? leaf + 1 : path;
+
+	transcript.name = leaf;
+	transcript.tool = -1;
+	for (int32 i = 0; i < (int32)B_COUNT_OF(kTools); i++) {
+		if (strncmp(leaf, kTools[i].name, strlen(kTools[i].name)) == 0)
+			transcript.tool = i;
+	}
+	if (transcript.tool < 0) {
+		fprintf(stderr, "%s: Don't know which tool wrote it\n", path);
+		return false;
+	}
+
+	FILE* file = fopen(path, "r");
+	if (file == NULL) {
+		fprintf(stderr, "%s: %s\n", path, strerror(errno));
+		return false;
+	}
+
+	char* buffer = NULL;
+	size_t size = 0;
+	ssize_t length;
+	while ((length = getline(&buffer, &size, file)) >= 0) {
+		if (length > 0 && buffer[length - 1] == '\n')
+			buffer[--length] = '\0';
+		if (length < 2 || (buffer[0] != '1' && buffer[0] != '2'))
+			continue;
+
+		transcript.streams.push_back(buffer[0] - '0');
+		transcript.lines.push_back(BString(buffer + 2, length - 2));
+	}
+	free(buffer);
+	fclose(file);
+	return true;
+}
+
+
+// Each line is searched for every message, like OutputParser used to
+static uint32
+find_each(const BString& line, const std::vector<const char*>& patterns)
+{
+	uint32 found = 0;
+	for (size_t i = 0; i < patterns.size(); i++) {
+		if (line.FindFirst(patterns[i]) != B_ERROR)
+			found |= 1UL << i;
+	}
+	return found;
+}
+
+
+static bigtime_t
+time_find_each(const Transcript& transcript, int32 repeats, uint32& found)
+{
+	const PatternMatcher& matcher = kTools[transcript.tool].matcher();
+	std::vector<const char*> patterns;
+	for (int32 i = 0; i < matcher.CountPatterns(); i++)
+		patterns.push_back(matcher.PatternAt(i));
+
+	bigtime_t start = system_time();
+	for (int32 repeat = 0; repeat < repeats; repeat++) {
+		for (size_t i = 0; i < transcript.lines.size(); i++)
+			found += find_each(transcript.lines[i], patterns);
+	}
+	return system_time() - start;
+}
+
+
+static bigtime_t
+time_matcher(const Transcript& transcript, int32 repeats, uint32& found)
+{
+	// The machine is built on first use, outside of the time taken
+	const PatternMatcher& matcher = kTools[transcript.tool].matcher();
+	bigtime_t start = system_time();
+	for (int32 repeat = 0; repeat < repeats; repeat++) {
+		for (size_t i = 0; i < transcript.lines.size(); i++)
+			found += matcher.Match(transcript.lines[i]);
+	}
+	return system_time() - start;
+}
+
+
+static bigtime_t
+time_old_parser(const Transcript& transcript, int32 repeats, int32& percent)
+{
+	float progress = 0;
+	BString eta;
+	int64 size = 0;
+
+	bigtime_t start = system_time();
+	for (int32 repeat = 0; repeat < repeats; repeat++) {
+		OldOutputParser parser(progress, eta);
+		// It was given the whole output shown so far, and put progress
+		// lines in there itself
+		BString text;
+		for (size_t i = 0; i < transcript.lines.size(); i++) {
+			const BString& line = transcript.lines[i];
+			int32 stream = transcript.streams[i];
+			int32 result = NOCHANGE;
+			switch (transcript.tool) {
+				case kCdrecord:
+					result = parser.ParseCdrecordLine(text, line, stream);
+					break;
+				case kMediainfo:
+					result = parser.ParseMediainfoLine(size, line);
+					break;
+				case kMkisofs:
+					result = parser.ParseMkisofsLine(text, line, stream);
+					break;
+				case kReadcd:
+					result = parser.ParseReadcdLine(text, line);
+					break;
+			}
+			if (result == PERCENT)
+				percent++;
+			else
+				text << "\n" << line;
+		}
+	}
+	return system_time() - start;
+}
+
+
+static bigtime_t
+time_new_parser(const Transcript& transcript, int32 repeats, int32& percent)
+{
+	float progress = 0;
+	BString eta;
+	int64 size = 0;
+
+	bigtime_t start = system_time();
+	for (int32 repeat = 0; repeat < repeats; repeat++) {
+		OutputParser parser(progress, eta);
+		for (size_t i = 0; i < transcript.lines.size(); i++) {
+			const BString& line = transcript.lines[i];
+			int32 stream = transcript.streams[i];
+			ParseEvent event;
+			switch (transcript.tool) {
+				case kCdrecord:
+					event = parser.ParseCdrecordLine(line, stream);
+					break;
+				case kMediainfo:
+					event.result = parser.ParseMediainfoLine(size, line);
+					break;
+				case kMkisofs:
+					event = parser.ParseMkisofsLine(line, stream);
+					break;
+				case kReadcd:
+					event = parser.ParseReadcdLine(line);
+					break;
+			}
+			if (event.result == PERCENT)
+				percent++;
+		}
+	}
+	return system_time() - start;
+}
+
+
+static double
+per_line(bigtime_t time, const Transcript& transcript, int32 repeats)
+{
+	return (double)time / (transcript.lines.size() * repeats);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	int32 repeats = 100;
+	int first = 1;
+	if (argc > 2 && strcmp(argv[1], "-r") == 0) {
+		repeats = max_c(atoi(argv[2]), 1);
+		first = 3;
+	}
+	if (first >= argc) {
+		fprintf(stderr, "Usage: %s [-r <repeats>] <transcript>...\n",
+			argv[0]);
+		return 1;
+	}
+
+	printf("%-20s %7s  %21s  %21s\n", "", "", "matching (us/line)",
+		"parsing (us/line)");
+	printf("%-20s %7s  %10s %10s  %10s %10s\n", "transcript", "lines",
+		"FindFirst", "matcher", "old", "new");
+
+	int status = 0;
+	for (int i = first; i < argc; i++) {
+		Transcript transcript;
+		if (!load_transcript(argv[i], transcript)) {
+			status = 1;
+			continue;
+		}
+		if (transcript.lines.empty())
+			continue;
+
+		uint32 oldFound = 0;
+		uint32 newFound = 0;
+		bigtime_t findTime = time_find_each(transcript, repeats, oldFound);
+		bigtime_t matchTime = time_matcher(transcript, repeats, newFound);
+
+		int32 oldPercent = 0;
+		int32 newPercent = 0;
+		bigtime_t oldTime = time_old_parser(transcript, repeats, oldPercent);
+		bigtime_t newTime = time_new_parser(transcript, repeats, newPercent);
+
+		printf("%-20s %7zu  %10.3f %10.3f  %10.3f %10.3f\n",
+			transcript.name.String(), transcript.lines.size(),
+			per_line(findTime, transcript, repeats),
+			per_line(matchTime, transcript, repeats),
+			per_line(oldTime, transcript, repeats),
+			per_line(newTime, transcript, repeats));
+
+		// Both have to see the same, or the times mean nothing
+		if (oldFound != newFound) {
+			fprintf(stderr, "%s: The matcher found other messages\n",
+				argv[i]);
+			status = 1;
+		}
+		if (oldPercent != newPercent) {
+			fprintf(stderr, "%s: %" B_PRId32 " progress lines, but %"
+				B_PRId32 " before\n", argv[i], newPercent, oldPercent);
+			status = 1;
+		}
+	}
+	return status;
+}
@@ -26,6 +26,7 @@ AppSettings::AppSettings()
 	:
 	fEject(true),
 	fCache(false),
+	fParallelRead(false),
 	fSpeed(5),
 	fPosition(150, 150, 700, 600),
 	fInfoWeight(0.5),
@@ -58,6 +59,10 @@ AppSettings::AppSettings()
 					fCache = false;
 					dirtySettings = true;
 				}
+				if (msg.FindBool("parallel_read", &fParallelRead) != B_OK) {
+					fParallelRead = false;
+					dirtySettings = true;
+				}
 				if (msg.FindInt32("speed", &fSpeed) != B_OK) {
 					fSpeed = 5;
 					dirtySettings = true;
@@ -102,6 +107,7 @@ AppSettings::~AppSettings()
 			msg.AddString("folder", fFolder);
 			msg.AddBool("eject", fEject);
 			msg.AddBool("cache", fCache);
+			msg.AddBool("parallel_read", fParallelRead);
 			msg.AddInt32("speed", fSpeed);
 			msg.AddRect("windowlocation", fPosition);
 			msg.AddFloat("audio_split_info", fInfoWeight);
@@ -145,6 +151,13 @@ AppSettings::GetCache()
 }
 
 
+bool
+AppSettings::GetParallelRead()
+{
+	return fParallelRead;
+}
+
+
 bool
 AppSettings::GetEject()
 {
@@ -215,6 +228,16 @@ AppSettings::SetCache(bool cache)
 }
 
 
+void
+AppSettings::SetParallelRead(bool parallel)
+{
+	if (fParallelRead == parallel)
+		return;
+	fParallelRead = parallel;
+	dirtySettings = true;
+}
+
+
 void
 AppSettings::SetSpeed(int32 speed)
 {
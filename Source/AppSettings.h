@@ -25,6 +25,7 @@ public:
 		void		GetCacheFolder(BPath& folder);
 		bool		GetEject();
 		bool		GetCache();
+		bool		GetParallelRead();
 		int32		GetSpeed();
 		BRect		GetWindowPosition();
 		void		GetSplitWeight(float& left, float& right);
@@ -33,6 +34,7 @@ public:
 		void		SetCacheFolder(BString folder);
 		void		SetEject(bool eject);
 		void		SetCache(bool cache);
+		void		SetParallelRead(bool parallel);
 		void		SetSpeed(int32 speed);
 		void		SetWindowPosition(BRect where);
 		void		SetSplitWeight(float left, float right);
@@ -43,6 +45,7 @@ private:
 		BString		fFolder;
 		bool		fEject;
 		bool		fCache;
+		bool		fParallelRead;
 		int32		fSpeed;
 		BRect		fPosition;
 		float		fInfoWeight;
@@ -156,6 +156,18 @@ BurnWindow::MessageReceived(BMessage* message)
 		case kClearCache:
 			_ClearCache();
 			break;
+		case kParallelRead:
+			{
+				AppSettings* settings = my_app->Settings();
+				bool mark = settings->GetParallelRead();
+
+				if (settings->Lock())
+					settings->SetParallelRead(!mark);
+				settings->Unlock();
+
+				fParallelReadItem->SetMarked(!mark);
+				break;
+			}
 		case kOpenWebsite:
 			_OpenWebSite();
 			break;
@@ -165,6 +177,18 @@ BurnWindow::MessageReceived(BMessage* message)
 		case kSpeedSlider:
 			_UpdateSpeedSlider(message);
 			break;
+		case kExtraDevice:
+		{
+			BMenuItem* item;
+			if (message->FindPointer("source", (void**)&item) == B_OK)
+				item->SetMarked(!item->IsMarked());
+			break;
+		}
+		case kOnTheFly:
+			// Only data and DVD folders can be burned on-the-fly
+			fCompilationDataView->MessageReceived(message);
+			fCompilationDVDView->MessageReceived(message);
+			break;
 		case B_REFS_RECEIVED:
 			// Redirect message to current tab
 			if (fTabView->FocusTab() == 0)
@@ -232,6 +256,16 @@ BurnWindow::_CreateMenuBar()
 	fCacheQuitItem = new BMenuItem(B_TRANSLATE("Clear cache on quit"),
 		new BMessage(kCacheQuit));
 	cacheMenu->AddItem(fCacheQuitItem);
+	cacheMenu->AddSeparatorItem();
+
+	// Only worth it with an SSD, a hard disk seeks between the files
+	fParallelReadItem = new BMenuItem(B_TRANSLATE(
+		"Read files in parallel when building"), new BMessage(kParallelRead));
+	cacheMenu->AddItem(fParallelReadItem);
+
+	// Filled with the drives found in _CreateToolBar()
+	fDrivesMenu = new BMenu(B_TRANSLATE("Copies"));
+	menuBar->AddItem(fDrivesMenu);
 
 	BMenu* helpMenu = new BMenu(B_TRANSLATE("Help"));
 	menuBar->AddItem(helpMenu);
@@ -245,6 +279,7 @@ BurnWindow::_CreateMenuBar()
 	//Apply settings (and disable unimplemented options)
 	AppSettings* settings = my_app->Settings();
 	fCacheQuitItem->SetMarked(settings->GetCache());
+	fParallelReadItem->SetMarked(settings->GetParallelRead());
 
 	return menuBar;
 }
@@ -286,6 +321,12 @@ BurnWindow::_CreateToolBar()
 		if (ix == 0)
 			deviceItem->SetMarked(true);
 		fDeviceMenu->AddItem(deviceItem);
+
+		BString copyString(B_TRANSLATE("Also burn on %device%"));
+		copyString.ReplaceFirst("%device%", deviceString);
+		BMessage* copyMessage = new BMessage(kExtraDevice);
+		copyMessage->AddInt32("device", ix);
+		fDrivesMenu->AddItem(new BMenuItem(copyString, copyMessage));
 	}
 
 	BMenuField* fDeviceMenuField = new BMenuField("DeviceMenuField", "",
@@ -298,8 +339,8 @@ BurnWindow::_CreateToolBar()
 //	Not implemented. Should be moved to DataView?
 //	fMultiCheck = new BCheckBox("MultiSessionCheckBox",
 //		B_TRANSLATE("MultiSession"), new BMessage());
-//	fOntheflyCheck = new BCheckBox("OnTheFlyCheckBox",
-//		B_TRANSLATE("On-the-fly"), new BMessage());
+	fOntheflyCheck = new BCheckBox("OnTheFlyCheckBox",
+		B_TRANSLATE("On-the-fly"), new BMessage(kOnTheFly));
 	fSimulationCheck = new BCheckBox("SimulationCheckBox",
 		B_TRANSLATE("Simulation"), new BMessage());
 	fEjectCheck = new BCheckBox("EjectCheckBox",
@@ -320,7 +361,6 @@ BurnWindow::_CreateToolBar()
 	AppSettings* settings = my_app->Settings();
 
 //	fMultiCheck->SetEnabled(false);
-//	fOntheflyCheck->SetEnabled(false);
 	fEjectCheck->SetValue((int32)settings->GetEject());
 	fSpeedSlider->SetValue(settings->GetSpeed());
 	_UpdateSpeedSlider(NULL);
@@ -333,7 +373,7 @@ BurnWindow::_CreateToolBar()
 				.AddGlue()
 				.AddGrid(kControlPadding, 0.0)
 //					.Add(fMultiCheck, 0, 0)
-//					.Add(fOntheflyCheck, 1, 0)
+					.Add(fOntheflyCheck, 1, 0)
 					.Add(fSimulationCheck, 0, 0)
 					.Add(fEjectCheck, 0, 1)
 					.End()
@@ -536,6 +576,12 @@ BurnWindow::_ClearCache()
 		entry->Remove();
 	}
 	path = cachePath;
+	ret = path.Append(kCacheFileDataSnapshot);
+	if (ret == B_OK) {
+		entry = new BEntry(path.Path());
+		entry->Remove();
+	}
+	path = cachePath;
 	ret = path.Append(kCacheFolderAudioClone);
 	if (ret == B_OK) {
 		entry = new BEntry(path.Path());
@@ -711,6 +757,21 @@ BurnWindow::GetSelectedDevice()
 }
 
 
+int32
+BurnWindow::GetBurnDevices(sdevice* array)
+{
+	// The selected device always comes first
+	int32 count = 0;
+	array[count++] = devices[selectedDevice];
+
+	for (int32 ix = 0; ix < fDrivesMenu->CountItems(); ix++) {
+		if (ix != selectedDevice && fDrivesMenu->ItemAt(ix)->IsMarked())
+			array[count++] = devices[ix];
+	}
+	return count;
+}
+
+
 sessionConfig
 BurnWindow::GetSessionConfig()
 {
@@ -721,7 +782,7 @@ BurnWindow::GetSessionConfig()
 		fConfig.mode = "-sao";
 
 //	fConfig.multisession = fMultiCheck->Value();
-//	fConfig.onthefly = fOntheflyCheck->Value();
+	fConfig.onthefly = fOntheflyCheck->Value();
 	fConfig.simulation = fSimulationCheck->Value();
 	fConfig.eject = fEjectCheck->Value();
 	// Speed slider value get's updated in _UpdateSpeedSlider()
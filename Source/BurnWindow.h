@@ -45,6 +45,9 @@ public:
 
 	void			FindDevices(sdevice* array);
 	sdevice			GetSelectedDevice();
+	// Fills "array" with the devices to burn on, the selected one and those
+	// checked in the "Copies" menu. Returns their number.
+	int32			GetBurnDevices(sdevice* array);
 	sessionConfig	GetSessionConfig();
 
 private:
@@ -68,9 +71,11 @@ private:
 
 	BMenu* 			fSessionMenu;
 	BMenu* 			fDeviceMenu;
+	BMenu*			fDrivesMenu;
 	BMenuItem*		fCacheQuitItem;
+	BMenuItem*		fParallelReadItem;
 //	BCheckBox* 		fMultiCheck;
-//	BCheckBox* 		fOntheflyCheck;
+	BCheckBox* 		fOntheflyCheck;
 	BCheckBox* 		fSimulationCheck;
 	BCheckBox* 		fEjectCheck;
 	BSlider* 		fSpeedSlider;
@@ -11,19 +11,62 @@
 //  (stdout/stderr) of other programs into memory.
 #include "CommandPipe.h"
 
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
+#include <Autolock.h>
 #include <image.h>
+#include <Locker.h>
 #include <Message.h>
 #include <Messenger.h>
 #include <String.h>
 
 
+static const size_t kReadBufferSize = 64 * 1024;
+static const size_t kMaxReadBufferSize = 1024 * 1024;
+static const bigtime_t kPollInterval = 250000;
+
+// Pipes are created close-on-exec, so they don't leak into commands spawned
+// by other threads. As that takes two steps, creating the pipes and spawning
+// the command that inherits them has to be serialized.
+static BLocker sSpawnLock("command pipe spawn");
+
+
+static void
+create_pipe(int* fds)
+{
+	if (pipe(fds) != 0) {
+		fds[0] = fds[1] = -1;
+		return;
+	}
+
+	fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+	fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+}
+
+
+static void
+close_pipe(int* fds)
+{
+	if (fds[0] >= 0)
+		close(fds[0]);
+	if (fds[1] >= 0)
+		close(fds[1]);
+	fds[0] = fds[1] = -1;
+}
+
+
 BCommandPipe::BCommandPipe()
 	:
 	fStdOutOpen(false),
-	fStdErrOpen(false)
+	fStdErrOpen(false),
+	fReadBuffer(),
+	fReadBufferSize()
 {
 }
 
@@ -31,6 +74,8 @@ BCommandPipe::BCommandPipe()
 BCommandPipe::~BCommandPipe()
 {
 	FlushArgs();
+	free(fReadBuffer[0]);
+	free(fReadBuffer[1]);
 }
 
 
@@ -113,66 +158,35 @@ BCommandPipe::PipeAll(int* stdOutAndErr) const
 {
 	// This function pipes both stdout and stderr to the same filedescriptor
 	// (stdOut)
-	int oldStdOut;
-	int oldStdErr;
-	pipe(stdOutAndErr);
-	oldStdOut = dup(STDOUT_FILENO);
-	oldStdErr = dup(STDERR_FILENO);
-	close(STDOUT_FILENO);
-	close(STDERR_FILENO);
-	// TODO: This looks broken, using "stdOutAndErr[1]" twice!
-	dup2(stdOutAndErr[1], STDOUT_FILENO);
-	dup2(stdOutAndErr[1], STDERR_FILENO);
-
-	// Construct the argv vector
-	int32 argc;
-	const char** argv = Argv(argc);
+	BAutolock _(sSpawnLock);
 
-	// Load the app image... and pass the args
-	thread_id appThread = load_image((int)argc, argv,
-		const_cast<const char**>(environ));
+	create_pipe(stdOutAndErr);
+	if (stdOutAndErr[0] < 0)
+		return B_ERROR;
 
-	dup2(oldStdOut, STDOUT_FILENO);
-	dup2(oldStdErr, STDERR_FILENO);
-	close(oldStdOut);
-	close(oldStdErr);
-
-	free(argv);
-
-	return appThread;
+	thread_id tid = _Spawn(-1, stdOutAndErr[1], stdOutAndErr[1]);
+	if (tid < 0)
+		close_pipe(stdOutAndErr);
+	return tid;
 }
 
 
 thread_id
 BCommandPipe::Pipe(int* stdOut, int* stdErr) const
 {
-	int oldStdOut;
-	int oldStdErr;
-	pipe(stdOut);
-	pipe(stdErr);
-	oldStdOut = dup(STDOUT_FILENO);
-	oldStdErr = dup(STDERR_FILENO);
-	close(STDOUT_FILENO);
-	close(STDERR_FILENO);
-	dup2(stdOut[1], STDOUT_FILENO);
-	dup2(stdErr[1], STDERR_FILENO);
-
-	// Construct the argv vector
-	int32 argc;
-	const char** argv = Argv(argc);
-
-	// Load the app image... and pass the args
-	thread_id appThread = load_image((int)argc, argv, const_cast<
-		const char**>(environ));
+	BAutolock _(sSpawnLock);
 
-	dup2(oldStdOut, STDOUT_FILENO);
-	dup2(oldStdErr, STDERR_FILENO);
-	close(oldStdOut);
-	close(oldStdErr);
+	create_pipe(stdOut);
+	create_pipe(stdErr);
+	thread_id tid = B_ERROR;
+	if (stdOut[0] >= 0 && stdErr[0] >= 0)
+		tid = _Spawn(-1, stdOut[1], stdErr[1]);
 
-	free(argv);
-
-	return appThread;
+	if (tid < 0) {
+		close_pipe(stdOut);
+		close_pipe(stdErr);
+	}
+	return tid;
 }
 
 
@@ -194,8 +208,8 @@ BCommandPipe::PipeInto(FILE** _out, FILE** _err)
 	Close();
 
 	thread_id tid = Pipe(fStdOut, fStdErr);
-	if (tid >= 0)
-		resume_thread(tid);
+	if (tid < 0)
+		return tid;
 
 	close(fStdErr[1]);
 	close(fStdOut[1]);
@@ -216,8 +230,8 @@ BCommandPipe::PipeInto(FILE** _outAndErr)
 	Close();
 
 	thread_id tid = PipeAll(fStdOut);
-	if (tid >= 0)
-		resume_thread(tid);
+	if (tid < 0)
+		return tid;
 
 	close(fStdOut[1]);
 	fStdOutOpen = true;
@@ -227,6 +241,81 @@ BCommandPipe::PipeInto(FILE** _outAndErr)
 }
 
 
+thread_id
+BCommandPipe::Spawn(int stdIn, int stdOut, int stdErr) const
+{
+	BAutolock _(sSpawnLock);
+	return _Spawn(stdIn, stdOut, stdErr);
+}
+
+
+/*static*/ status_t
+BCommandPipe::CreatePipe(int* fds)
+{
+	BAutolock _(sSpawnLock);
+
+	create_pipe(fds);
+	if (fds[0] < 0)
+		return errno;
+
+	return B_OK;
+}
+
+
+thread_id
+BCommandPipe::_Spawn(int stdIn, int stdOut, int stdErr) const
+{
+	// Redirects the streams of the child only, via file actions that are
+	// applied after it has been forked off.
+	int32 argc;
+	const char** argv = Argv(argc);
+	if (argc == 0) {
+		free(argv);
+		return B_BAD_VALUE;
+	}
+
+	posix_spawn_file_actions_t actions;
+	int result = posix_spawn_file_actions_init(&actions);
+	if (result != 0) {
+		free(argv);
+		return result;
+	}
+
+	posix_spawnattr_t attributes;
+	result = posix_spawnattr_init(&attributes);
+	if (result != 0) {
+		posix_spawn_file_actions_destroy(&actions);
+		free(argv);
+		return result;
+	}
+
+	if (stdIn >= 0)
+		posix_spawn_file_actions_adddup2(&actions, stdIn, STDIN_FILENO);
+	if (stdOut >= 0)
+		posix_spawn_file_actions_adddup2(&actions, stdOut, STDOUT_FILENO);
+	if (stdErr >= 0)
+		posix_spawn_file_actions_adddup2(&actions, stdErr, STDERR_FILENO);
+
+	// Start a new process group with the child as its leader
+	posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETPGROUP);
+	posix_spawnattr_setpgroup(&attributes, 0);
+
+	pid_t child;
+	result = posix_spawnp(&child, argv[0], &actions, &attributes,
+		const_cast<char* const*>(argv), environ);
+
+	posix_spawnattr_destroy(&attributes);
+	posix_spawn_file_actions_destroy(&actions);
+	free(argv);
+
+	if (result != 0)
+		return result;
+
+	// The team ID equals the ID of its main thread
+	return child;
+}
+
+
 // #pragma mark -
 
 
@@ -253,8 +342,8 @@ BCommandPipe::RunAsync()
 	// to system() but uses pipes.... Asynchronous.
 	Close();
 	FILE* f = NULL;
-	PipeInto(&f);
-	fclose(f);
+	if (PipeInto(&f) >= 0)
+		fclose(f);
 }
 
 
@@ -262,34 +351,224 @@ BCommandPipe::RunAsync()
 
 
 status_t
-BCommandPipe::ReadLines(FILE* file, LineReader* lineReader)
+BCommandPipe::LineReader::ReadLine(const char* line, int32 length)
+{
+	return ReadLine(BString(line, length));
+}
+
+
+status_t
+BCommandPipe::LineReader::ReadLine(const char* line, int32 length, int stream)
 {
-	// Reads output of file, line by line. Each line is passed to lineReader
-	// for inspection, and the IsCanceled() method is repeatedly called.
+	return ReadLine(line, length);
+}
 
+
+status_t
+BCommandPipe::ReadLines(FILE* file, LineReader* lineReader)
+{
 	if (file == NULL || lineReader == NULL)
 		return B_BAD_VALUE;
 
-	BString line;
+	FILE* files[1] = { file };
+	return _ReadLines(files, 1, lineReader);
+}
+
 
-	while (!feof(file)) {
+status_t
+BCommandPipe::ReadLines(FILE* out, FILE* err, LineReader* lineReader)
+{
+	if (out == NULL || err == NULL || lineReader == NULL)
+		return B_BAD_VALUE;
+
+	FILE* files[2] = { out, err };
+	return _ReadLines(files, 2, lineReader);
+}
+
+
+status_t
+BCommandPipe::_ReadLines(FILE** files, int32 count, LineReader* lineReader)
+{
+	// Reads output of the files in large blocks and splits them into lines.
+	// Each line is passed to lineReader for inspection, and the IsCanceled()
+	// method is called once per block. All files are waited on at once.
+
+	struct pollfd pollInfos[2];
+	// [start, end) holds the beginning of a line that isn't complete yet
+	size_t start[2] = { 0, 0 };
+	size_t end[2] = { 0, 0 };
+
+	for (int32 i = 0; i < count; i++) {
+		int fd = fileno(files[i]);
+		if (fd < 0)
+			return B_BAD_VALUE;
+
+		pollInfos[i].fd = fd;
+		pollInfos[i].events = POLLIN;
+		pollInfos[i].revents = 0;
+
+		if (fReadBuffer[i] == NULL) {
+			fReadBuffer[i] = static_cast<char*>(malloc(kReadBufferSize));
+			if (fReadBuffer[i] == NULL)
+				return B_NO_MEMORY;
+			fReadBufferSize[i] = kReadBufferSize;
+		}
+	}
+
+	bigtime_t timeout = lineReader->Timeout();
+	bigtime_t lastOutput = system_time();
+	bigtime_t stallTime = B_INFINITE_TIMEOUT;
+	if (timeout != B_INFINITE_TIMEOUT)
+		stallTime = lastOutput + timeout;
+
+	int32 openCount = count;
+	while (openCount > 0) {
 		if (lineReader->IsCanceled())
 			return B_CANCELED;
 
-		unsigned char c = fgetc(file);
-			// TODO: fgetc() blocks, is there a way to make it timeout?
+		// Wait for output, but wake up regularly to check for cancellation
+		bigtime_t wait = min_c(kPollInterval, lineReader->Flush(false));
+		if (timeout != B_INFINITE_TIMEOUT)
+			wait = max_c(0, min_c(wait, stallTime - system_time()));
+
+		// Files that have ended have a negative fd, and are ignored
+		int ready = poll(pollInfos, count, (wait + 999) / 1000);
+		if (ready < 0) {
+			if (errno == EINTR)
+				continue;
+			return errno;
+		}
+		if (ready == 0) {
+			bigtime_t now = system_time();
+			if (timeout != B_INFINITE_TIMEOUT && now >= stallTime) {
+				status_t ret = lineReader->Stalled(now - lastOutput);
+				if (ret != B_OK)
+					return ret;
+				stallTime = now + timeout;
+			}
+			continue;
+		}
+
+		for (int32 i = 0; i < count; i++) {
+			if (pollInfos[i].fd < 0 || pollInfos[i].revents == 0)
+				continue;
+
+			bool ended = false;
+			status_t ret = _ReadBlock(i, pollInfos[i].fd, start[i], end[i],
+				lineReader, ended);
+			if (ret != B_OK)
+				return ret;
+
+			if (ended) {
+				pollInfos[i].fd = -1;
+				openCount--;
+				continue;
+			}
+
+			lastOutput = system_time();
+			if (timeout != B_INFINITE_TIMEOUT)
+				stallTime = lastOutput + timeout;
+		}
+	}
 
-		if (c != 255)
-			line << (char)c;
+	lineReader->Flush(true);
+	return B_OK;
+}
 
-		if (c == '\n' || c == '\r') {
-			status_t ret = lineReader->ReadLine(line);
+
+status_t
+BCommandPipe::_ReadBlock(int32 index, int fd, size_t& start, size_t& end,
+	LineReader* lineReader, bool& _ended)
+{
+	// Reads what's available from fd into the read buffer of the stream
+	// "index", and passes on all complete lines. At the end of the file,
+	// the last line is passed on even if it isn't terminated.
+
+	int stream = index == 0 ? STDOUT_FILENO : STDERR_FILENO;
+	char*& buffer = fReadBuffer[index];
+	size_t& bufferSize = fReadBufferSize[index];
+
+	if (end == bufferSize) {
+		if (start > 0) {
+			// move the incomplete line to the front to make room
+			memmove(buffer, buffer + start, end - start);
+			end -= start;
+			start = 0;
+		} else if (bufferSize < kMaxReadBufferSize) {
+			char* grown = static_cast<char*>(realloc(buffer, bufferSize * 2));
+			if (grown == NULL)
+				return B_NO_MEMORY;
+			buffer = grown;
+			bufferSize *= 2;
+		} else {
+			// an overly long line, pass on what we have so far
+			status_t ret = lineReader->ReadLine(buffer, end, stream);
 			if (ret != B_OK)
 				return ret;
-			line = "";
+			start = end = 0;
+		}
+	}
+
+	ssize_t bytesRead = read(fd, buffer + end, bufferSize - end);
+	if (bytesRead < 0) {
+		if (errno == EINTR || errno == EAGAIN)
+			return B_OK;
+		return errno;
+	}
+	if (bytesRead == 0) {
+		_ended = true;
+
+		// the last line may not be terminated
+		if (end > start) {
+			status_t ret = lineReader->ReadLine(buffer + start, end - start,
+				stream);
+			start = end = 0;
+			return ret;
+		}
+		return B_OK;
+	}
+
+	char* scan = buffer + end;
+	end += bytesRead;
+	char* bufferEnd = buffer + end;
+
+	// Lines end in either '\n' or '\r' (progress output). Remember the
+	// next occurrence of both, so each byte is only looked at once.
+	char* nextNewline = static_cast<char*>(
+		memchr(scan, '\n', bufferEnd - scan));
+	char* nextReturn = static_cast<char*>(
+		memchr(scan, '\r', bufferEnd - scan));
+
+	while (nextNewline != NULL || nextReturn != NULL) {
+		char* lineEnd;
+		if (nextNewline == NULL)
+			lineEnd = nextReturn;
+		else if (nextReturn == NULL)
+			lineEnd = nextNewline;
+		else
+			lineEnd = nextNewline < nextReturn ? nextNewline : nextReturn;
+
+		char* line = buffer + start;
+		status_t ret = lineReader->ReadLine(line, lineEnd + 1 - line, stream);
+		if (ret != B_OK)
+			return ret;
+
+		scan = lineEnd + 1;
+		start = scan - buffer;
+
+		if (nextNewline == lineEnd) {
+			nextNewline = static_cast<char*>(
+				memchr(scan, '\n', bufferEnd - scan));
+		}
+		if (nextReturn == lineEnd) {
+			nextReturn = static_cast<char*>(
+				memchr(scan, '\r', bufferEnd - scan));
 		}
 	}
 
+	if (start == end)
+		start = end = 0;
+
 	return B_OK;
 }
 
@@ -312,10 +591,14 @@ BCommandPipe::ReadLines(FILE* file)
 
 		virtual status_t ReadLine(const BString& line)
 		{
-			int lineLength = line.Length();
+			return ReadLine(line.String(), line.Length());
+		}
+
+		virtual status_t ReadLine(const char* line, int32 length)
+		{
 			int resultLength = fResult.Length();
-			fResult << line;
-			if (fResult.Length() != lineLength + resultLength)
+			fResult.Append(line, length);
+			if (fResult.Length() != length + resultLength)
 				return B_NO_MEMORY;
 			return B_OK;
 		}
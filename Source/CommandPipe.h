@@ -41,6 +41,12 @@ public:
 
 	// If you use these, you must explicitly call "close" for the parameters
 	// (stdOut/stdErr) when you are done with them!
+	// The command is spawned with its stdout/stderr connected to the pipes,
+	// the streams of the calling team are left alone. The command is already
+	// running when these return, and they may be used from several threads
+	// at once. It is the leader of a new process group, so it can be
+	// signalled together with any commands it starts itself. When they
+	// fail, no pipe is left open, and all its ends are set to -1.
 			thread_id			Pipe(int* stdOut, int* stdErr) const;
 			thread_id			Pipe(int* stdOut) const;
 			thread_id			PipeAll(int* stdOutAndErr) const;
@@ -48,10 +54,18 @@ public:
 	// If you use these, you need NOT call "fclose" for the parameters
 	// (out/err) when you are done with them, also you need not do any
 	// allocation for these FILE* pointers, just use FILE* out = NULL
-	// and pass &out and so on...
+	// and pass &out and so on... When they fail, they are left alone.
 			thread_id			PipeInto(FILE** _out, FILE** _err);
 			thread_id			PipeInto(FILE** _outAndErr);
 
+	// Spawns the command with the given file descriptors as its stdin,
+	// stdout and stderr. A negative one leaves the stream of the calling
+	// team. The descriptors are not closed.
+			thread_id			Spawn(int stdIn, int stdOut, int stdErr) const;
+	// Creates a pipe that is closed on exec, without it leaking into any
+	// command spawned at the same time.
+	static	status_t			CreatePipe(int* fds);
+
 	// Run() is a synchronous call, and waits till the command has finished
 	// executing RunAsync() is an asynchronous call that returns immediately
 	// after launching the command Neither of these bother about redirecting
@@ -66,13 +80,46 @@ public:
 				virtual				~LineReader() {}
 				virtual	bool		IsCanceled() = 0;
 				virtual	status_t	ReadLine(const BString& line) = 0;
-				// TODO: Add a Timeout() method.
+				// "line" points into the read buffer and is only valid
+				// during the call. It is not null-terminated, but includes
+				// the line break. The default implementation copies it into
+				// a BString and passes that on to ReadLine() above.
+				virtual	status_t	ReadLine(const char* line, int32 length);
+				// Like the above, with the stream the line was written to,
+				// STDOUT_FILENO or STDERR_FILENO. When both are read as
+				// one, the stream is always STDOUT_FILENO.
+				virtual	status_t	ReadLine(const char* line, int32 length,
+										int stream);
+				// Time without any output after which Stalled() is called.
+				virtual	bigtime_t	Timeout() { return B_INFINITE_TIMEOUT; }
+				// Called with the time since the last output, whenever
+				// another Timeout() has passed without output. Reading goes
+				// on if it returns B_OK, otherwise ReadLines() fails with
+				// the returned error.
+				virtual	status_t	Stalled(bigtime_t idleTime)
+									{ return B_TIMED_OUT; }
+				// Called before waiting for more output, and with "force"
+				// set after the last line. Readers that hold lines back to
+				// pass them on in batches deliver them here. Returns how
+				// long they may wait until they're called again, or
+				// B_INFINITE_TIMEOUT if nothing is held back.
+				virtual	bigtime_t	Flush(bool force)
+										{ return B_INFINITE_TIMEOUT; }
 			};
 
-	// This function reads line-by-line from "file". It calls IsCanceled()
-	// on the passed LineReader instance for each byte read from file
-	// (currently). And it calls ReadLine() for each complete line.
+	// This function reads line-by-line from "file". It reads large blocks
+	// directly from the underlying file descriptor and calls IsCanceled()
+	// on the passed LineReader instance once for each block, and regularly
+	// while there's no output. It calls ReadLine() for each complete line,
+	// and once more for any trailing data that isn't terminated by a line
+	// break. Flush() is called before waiting for output, and at the end.
+	// Note: As the file descriptor is read directly, "file" must not have
+	// been read from via stdio before.
 			status_t			ReadLines(FILE* file, LineReader* lineReader);
+	// Reads the separate output and error streams of a command at the same
+	// time, and tells their lines apart.
+			status_t			ReadLines(FILE* out, FILE* err,
+									LineReader* lineReader);
 	// This method can be used to read the entire file into a BString.
 			BString				ReadLines(FILE* file);
 
@@ -84,11 +131,22 @@ public:
 			BCommandPipe&		operator<<(const BCommandPipe& arg);
 
 protected:
+			thread_id			_Spawn(int stdIn, int stdOut,
+									int stdErr) const;
+			status_t			_ReadLines(FILE** files, int32 count,
+									LineReader* lineReader);
+			status_t			_ReadBlock(int32 index, int fd, size_t& start,
+									size_t& end, LineReader* lineReader,
+									bool& _ended);
+
 			BList				fArgList;
 			int					fStdOut[2];
 			int					fStdErr[2];
 			bool				fStdOutOpen;
 			bool				fStdErrOpen;
+
+			char*				fReadBuffer[2];
+			size_t				fReadBufferSize[2];
 };
 
 }	// namespace BPrivate
@@ -6,47 +6,243 @@
 #include "CommandThread.h"
 #include "CommandPipe.h"
 
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
 #include <AutoLocker.h>
 
-bool started = false;
+// How long a stopped command gets to quit before it is killed
+static const bigtime_t kTerminateTimeout = 5000000;
+// How often the resource usage of a running command is looked at
+static const bigtime_t kUsageInterval = 250000;
+// Output lines are passed on in batches, at most once per frame
+static const bigtime_t kBatchInterval = 1000000 / 60;
+static const int32 kMaxBatchLines = 256;
+// How long sending a message may block before checking whether the thread
+// is being deleted
+static const bigtime_t kDeliverTimeout = 250000;
+// How often the fill level of the fifo of an input command is reported
+static const bigtime_t kFifoInterval = 250000;
 
 class CommandReader : public BPrivate::BCommandPipe::LineReader
 {
 public:
-	CommandReader(BInvoker* invoker)
+	CommandReader(CommandThread* commandThread, bool separateStreams)
 	:
-	fInvoker(invoker) {}
+	fCommandThread(commandThread),
+	fInvoker(commandThread->Invoker()),
+	fSeparateStreams(separateStreams),
+	fBatch(NULL),
+	fLineCount(0),
+	fProgressStream(STDOUT_FILENO),
+	fProgressTime(0),
+	fHasProgress(false),
+	fLastWasProgress(false),
+	fLastSent(0),
+	fFifoFill(-1),
+	fFifoSent(0) {}
+
+
+	~CommandReader()
+	{
+		delete fBatch;
+	}
 
 
 	virtual bool IsCanceled()
 	{
-		// TODO Handle cancel
-		return false;
+		// This is called regularly while the command runs, so it's also
+		// used to keep track of its resource usage
+		fCommandThread->_SampleUsage();
+		_ReportFifo();
+		return atomic_get(&fCommandThread->fCanceled) != 0;
+	}
+
+	virtual bigtime_t Timeout()
+	{
+		return fCommandThread->Timeout();
+	}
+
+	virtual status_t Stalled(bigtime_t idleTime)
+	{
+		// Just report it, it's up to the owner to stop the command
+		if (fInvoker != NULL) {
+			BMessage messageCopy(*fInvoker->Message());
+			messageCopy.AddInt64("stalled", idleTime);
+			fCommandThread->_Deliver(&messageCopy);
+		}
+		return B_OK;
 	}
 
 	virtual status_t ReadLine(const BString& line)
+	{
+		return ReadLine(line.String(), line.Length());
+	}
+
+	virtual status_t ReadLine(const char* line, int32 length)
+	{
+		return ReadLine(line, length, STDOUT_FILENO);
+	}
+
+	virtual status_t ReadLine(const char* line, int32 length, int stream)
 	{
 		if (fInvoker == NULL)
 			return B_OK;
 
-		BMessage messageCopy(*fInvoker->Message());
-		BString lineCopy(line);
-		lineCopy.RemoveLast("\n");
-		messageCopy.AddString("line", lineCopy);
-		fInvoker->Invoke(&messageCopy);
+		bigtime_t when = system_time();
+
+		bool progress = false;
+		if (length > 0 && line[length - 1] == '\r') {
+			progress = true;
+			length--;
+		} else if (length > 0 && line[length - 1] == '\n')
+			length--;
+
+		if (progress) {
+			// Only the latest of consecutive progress lines is passed on
+			if (stream != fProgressStream)
+				_AddProgress();
+
+			fProgressLine.SetTo(line, length);
+			fProgressStream = stream;
+			fProgressTime = when;
+			fHasProgress = true;
+			fLastWasProgress = true;
+			return B_OK;
+		}
+
+		// An empty line right after a progress line is just the second half
+		// of a "\r\n" line break
+		bool lineBreak = length == 0 && fLastWasProgress;
+		fLastWasProgress = false;
+
+		_AddProgress();
+		if (!lineBreak)
+			_AddLine(BString(line, length), stream, when);
+
+		if (fLineCount >= kMaxBatchLines)
+			_Send();
 
 		return B_OK;
 	}
 
+	virtual bigtime_t Flush(bool force)
+	{
+		if (fLineCount == 0 && !fHasProgress)
+			return B_INFINITE_TIMEOUT;
+
+		bigtime_t now = system_time();
+		if (!force && now < fLastSent + kBatchInterval)
+			return fLastSent + kBatchInterval - now;
+
+		_AddProgress();
+		_Send();
+		return B_INFINITE_TIMEOUT;
+	}
+
 private:
+	void _ReportFifo()
+	{
+		if (fInvoker == NULL || fCommandThread->fPumpThread < 0)
+			return;
+
+		int32 fill = atomic_get(&fCommandThread->fFifoFill);
+		bigtime_t now = system_time();
+		if (fill == fFifoFill || now < fFifoSent + kFifoInterval)
+			return;
+
+		BMessage messageCopy(*fInvoker->Message());
+		messageCopy.AddInt32("fifo_fill", fill);
+		fCommandThread->_Deliver(&messageCopy);
+		fFifoFill = fill;
+		fFifoSent = now;
+	}
+
+	void _AddProgress()
+	{
+		if (!fHasProgress)
+			return;
+
+		_AddLine(fProgressLine, fProgressStream, fProgressTime);
+		fHasProgress = false;
+	}
+
+	void _AddLine(const BString& line, int stream, bigtime_t when)
+	{
+		if (fBatch == NULL)
+			fBatch = new BMessage(*fInvoker->Message());
+
+		// Each "line" has a "when" at the same index, and a "stream" if the
+		// streams are read separately
+		fBatch->AddString("line", line);
+		fBatch->AddInt64("when", when);
+		if (fSeparateStreams)
+			fBatch->AddInt32("stream", stream);
+		fLineCount++;
+	}
+
+	void _Send()
+	{
+		if (fBatch == NULL)
+			return;
+
+		fCommandThread->_Deliver(fBatch);
+		delete fBatch;
+		fBatch = NULL;
+		fLineCount = 0;
+		fLastSent = system_time();
+	}
+
+	CommandThread* fCommandThread;
 	BInvoker* fInvoker;
+	bool fSeparateStreams;
+
+	BMessage* fBatch;
+	int32 fLineCount;
+	BString fProgressLine;
+	int fProgressStream;
+	bigtime_t fProgressTime;
+	bool fHasProgress;
+	bool fLastWasProgress;
+	bigtime_t fLastSent;
+	int32 fFifoFill;
+	bigtime_t fFifoSent;
 };
 
 
 CommandThread::CommandThread(BObjectList<BString>* argList, BInvoker* invoker)
 	:
 	fArgumentList(argList),
-	fInvoker(invoker)
+	fInvoker(invoker),
+	fThread(-1),
+	fChild(-1),
+	fTimeout(B_INFINITE_TIMEOUT),
+	fSeparateStreams(false),
+	fState(COMMAND_CREATED),
+	fCanceled(0),
+	fQuitting(0),
+	fExitCode(-1),
+	fExitSignal(0),
+	fStartTime(0),
+	fLastSample(0),
+	fWallTime(0),
+	fUserTime(0),
+	fKernelTime(0),
+	fPeakMemory(0),
+	fInputArguments(NULL),
+	fFifoSize(0),
+	fInputChild(-1),
+	fPumpThread(-1),
+	fPumpIn(-1),
+	fPumpOut(-1),
+	fFifoFill(0),
+	fInputExitCode(-1)
 {
 	if (fArgumentList == NULL)
 		fArgumentList = new BObjectList<BString>(5, true);
@@ -55,8 +251,14 @@ CommandThread::CommandThread(BObjectList<BString>* argList, BInvoker* invoker)
 
 CommandThread::~CommandThread()
 {
+	// The thread must be done with this object before it goes away
+	atomic_set(&fQuitting, 1);
+	Stop();
+	Wait();
+
 	delete fInvoker;
 	delete fArgumentList;
+	delete fInputArguments;
 }
 
 
@@ -105,21 +307,92 @@ void CommandThread::SetInvoker(BInvoker* invoker)
 }
 
 
+bigtime_t
+CommandThread::Timeout()
+{
+	AutoLocker<CommandThread> locker(this);
+	return fTimeout;
+}
+
+
+void
+CommandThread::SetTimeout(bigtime_t timeout)
+{
+	AutoLocker<CommandThread> locker(this);
+	fTimeout = timeout;
+}
+
+
+bool
+CommandThread::SeparateStreams()
+{
+	AutoLocker<CommandThread> locker(this);
+	return fSeparateStreams;
+}
+
+
+void
+CommandThread::SetSeparateStreams(bool separate)
+{
+	AutoLocker<CommandThread> locker(this);
+	fSeparateStreams = separate;
+}
+
+
+void
+CommandThread::SetInputCommand(BObjectList<BString>* arguments,
+	size_t fifoSize)
+{
+	AutoLocker<CommandThread> locker(this);
+	delete fInputArguments;
+	fInputArguments = arguments;
+	fFifoSize = fifoSize;
+}
+
+
 status_t
 CommandThread::Run()
 {
 	AutoLocker<CommandThread> locker(this);
 
-	// TODO Check if thread is already running
+	if (atomic_get(&fState) == COMMAND_RUNNING)
+		return B_BUSY;
+
+	// The thread of the last run may still be on its way out. It doesn't
+	// need the lock anymore once it has left the running state.
+	if (fThread >= 0) {
+		status_t status;
+		wait_for_thread(fThread, &status);
+		fThread = -1;
+	}
+
+	atomic_set(&fCanceled, 0);
+	fChild = -1;
+	fInputChild = -1;
+	fPumpThread = -1;
+	fInputExitCode = -1;
+	atomic_set(&fFifoFill, 0);
+
+	fExitCode = -1;
+	fExitSignal = 0;
+	fWallTime = fUserTime = fKernelTime = 0;
+	fPeakMemory = 0;
+
 	fThread = spawn_thread(CommandThread::_Thread, "command thread",
 		B_NORMAL_PRIORITY, this);
-	if (fThread < B_OK)
+	if (fThread < B_OK) {
+		fThread = -1;
 		return B_ERROR;
+	}
 
-	if (resume_thread(fThread) != B_OK)
+	atomic_set(&fState, COMMAND_RUNNING);
+	if (resume_thread(fThread) != B_OK) {
+		kill_thread(fThread);
+		fThread = -1;
+		atomic_set(&fState, COMMAND_EXITED);
 		return B_ERROR;
+	}
 
-	started = true;
 	return B_OK;
 }
 
@@ -128,16 +401,44 @@ status_t
 CommandThread::Stop()
 {
 	AutoLocker<CommandThread> locker(this);
-	return B_ERROR;
+	atomic_set(&fCanceled, 1);
+
+	if (fInputChild >= 0)
+		kill(-fInputChild, SIGTERM);
+
+	// If the command isn't started yet, it's stopped once it is
+	if (fChild < 0)
+		return B_OK;
+
+	// Signal the whole process group, the command may have started others
+	if (kill(-fChild, SIGTERM) != 0)
+		return errno;
+
+	return B_OK;
 }
 
 
 status_t
 CommandThread::Wait()
 {
-	AutoLocker<CommandThread> locker(this);
+	// The lock must not be held while waiting, the thread needs it
+	thread_id thread;
+	{
+		AutoLocker<CommandThread> locker(this);
+		thread = fThread;
+	}
+	if (thread < 0)
+		return B_OK;
+
 	status_t status;
-	wait_for_thread(fThread, &status);
+	status_t result = wait_for_thread(thread, &status);
+	if (result == B_BAD_THREAD_ID) {
+		// someone else has waited for it already
+		return B_OK;
+	}
+	if (result != B_OK)
+		return result;
+
 	return status;
 }
 
@@ -145,7 +446,14 @@ CommandThread::Wait()
 bool
 CommandThread::IsRunning()
 {
-	return started;
+	return atomic_get(&fState) == COMMAND_RUNNING;
+}
+
+
+command_state
+CommandThread::State()
+{
+	return (command_state)atomic_get(&fState);
 }
 
 
@@ -171,25 +479,141 @@ CommandThread::_Thread(void* data)
 
 	pipe.PrintToStream();
 
-	FILE* stdOutAndErrPipe = NULL;
-
-	thread_id pipeThread = pipe.PipeInto(&stdOutAndErrPipe);
+	bool separateStreams = commandThread->SeparateStreams();
+	FILE* stdOutPipe = NULL;
+	FILE* stdErrPipe = NULL;
+
+	thread_id pipeThread;
+	if (commandThread->fInputArguments != NULL) {
+		pipeThread = commandThread->_SpawnWithInput(pipe, &stdOutPipe,
+			&stdErrPipe);
+	} else if (separateStreams)
+		pipeThread = pipe.PipeInto(&stdOutPipe, &stdErrPipe);
+	else
+		pipeThread = pipe.PipeInto(&stdOutPipe);
 	if (pipeThread < B_OK)
 		return B_ERROR;
 
+	commandThread->_SetChild(pipeThread);
+
 	if (*args->ItemAt(0) == "cdrecord")
 		set_thread_priority(pipeThread, B_DISPLAY_PRIORITY);
 
-	BPrivate::BCommandPipe::LineReader* reader
-		= new CommandReader(commandThread->Invoker());
+	CommandReader reader(commandThread, separateStreams);
 
-	if (pipe.ReadLines(stdOutAndErrPipe, reader) != B_OK) {
-		kill_thread(pipeThread);
-		status_t exitval;
-		wait_for_thread(pipeThread, &exitval);
-		return B_ERROR;
+	status_t status;
+	if (separateStreams)
+		status = pipe.ReadLines(stdOutPipe, stdErrPipe, &reader);
+	else
+		status = pipe.ReadLines(stdOutPipe, &reader);
+
+	bool failed = status != B_OK || reader.IsCanceled();
+	if (failed) {
+		// Pass on what was read so far before the exit is reported
+		reader.Flush(true);
 	}
-	return B_OK;
+	commandThread->_WaitForChild(pipeThread, failed);
+
+	if (commandThread->fInputArguments != NULL) {
+		// The input command is stopped as well if this one failed
+		commandThread->_WaitForInput(failed
+			|| commandThread->fExitCode != 0);
+
+		// These weren't opened by the pipe, so it doesn't close them
+		fclose(stdOutPipe);
+		if (stdErrPipe != NULL)
+			fclose(stdErrPipe);
+	}
+
+	return failed ? B_ERROR : B_OK;
+}
+
+
+int32
+CommandThread::_Pump(void* data)
+{
+	CommandThread* commandThread = static_cast<CommandThread*>(data);
+	int in = commandThread->fPumpIn;
+	int out = commandThread->fPumpOut;
+	size_t size = commandThread->fFifoSize;
+
+	// A command that quits early must not take down the whole team
+	sigset_t set;
+	sigemptyset(&set);
+	sigaddset(&set, SIGPIPE);
+	pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+	fcntl(in, F_SETFL, fcntl(in, F_GETFL) | O_NONBLOCK);
+	fcntl(out, F_SETFL, fcntl(out, F_GETFL) | O_NONBLOCK);
+
+	char* buffer = (char*)malloc(size);
+	if (buffer == NULL) {
+		close(in);
+		close(out);
+		return B_NO_MEMORY;
+	}
+
+	// A ring buffer, "count" bytes starting at "head" are waiting to be
+	// written
+	size_t head = 0;
+	size_t count = 0;
+	bool inputEnded = false;
+	status_t status = B_OK;
+
+	while (atomic_get(&commandThread->fCanceled) == 0) {
+		if (inputEnded && count == 0)
+			break;
+
+		pollfd fds[2];
+		fds[0].fd = count < size && !inputEnded ? in : -1;
+		fds[0].events = POLLIN;
+		fds[0].revents = 0;
+		fds[1].fd = count > 0 ? out : -1;
+		fds[1].events = POLLOUT;
+		fds[1].revents = 0;
+
+		// Time out now and then to check whether it has been stopped
+		int result = poll(fds, 2, kFifoInterval / 1000);
+		if (result < 0) {
+			if (errno == EINTR)
+				continue;
+			status = errno;
+			break;
+		}
+
+		if ((fds[0].revents & (POLLIN | POLLHUP | POLLERR)) != 0) {
+			size_t tail = (head + count) % size;
+			size_t space = tail >= head ? size - tail : head - tail;
+			ssize_t bytesRead = read(in, buffer + tail,
+				min_c(space, size - count));
+			if (bytesRead > 0)
+				count += bytesRead;
+			else if (bytesRead == 0 || (errno != EAGAIN && errno != EINTR))
+				inputEnded = true;
+		}
+
+		if ((fds[1].revents & (POLLOUT | POLLHUP | POLLERR)) != 0) {
+			size_t chunk = min_c(count, size - head);
+			ssize_t bytesWritten = write(out, buffer + head, chunk);
+			if (bytesWritten > 0) {
+				head = (head + bytesWritten) % size;
+				count -= bytesWritten;
+			} else if (bytesWritten < 0 && errno != EAGAIN
+				&& errno != EINTR) {
+				// The command doesn't read anymore
+				status = errno;
+				break;
+			}
+		}
+
+		atomic_set(&commandThread->fFifoFill, (int32)(count * 100 / size));
+	}
+
+	free(buffer);
+	close(in);
+	// Closing it lets the command see the end of its input
+	close(out);
+	return status;
 }
 
 
@@ -200,14 +624,268 @@ CommandThread::_ThreadExit(void* data)
 	if (commandThread == NULL)
 		return;
 
-	BInvoker* invoker = commandThread->Invoker();
+	commandThread->_SetChild(-1);
+
+	BInvoker* invoker;
+	{
+		AutoLocker<CommandThread> locker(commandThread);
+		invoker = commandThread->fInvoker;
+		atomic_set(&commandThread->fState,
+			atomic_get(&commandThread->fCanceled) != 0
+				? COMMAND_CANCELED : COMMAND_EXITED);
+	}
 	if (invoker == NULL)
 		return;
 
+	// From here on, the lock must not be used anymore, see Run()
 	BMessage copy(*invoker->Message());
 
-	// TODO adjust this based on the actual command exit code
-	copy.AddInt32("thread_exit", 0);
-	invoker->Invoke(&copy);
-	started = false;
+	// The exit code of the command, -1 if it couldn't be started
+	copy.AddInt32("thread_exit", commandThread->fExitCode);
+	if (commandThread->fExitSignal != 0)
+		copy.AddInt32("exit_signal", commandThread->fExitSignal);
+	if (atomic_get(&commandThread->fCanceled) != 0)
+		copy.AddBool("canceled", true);
+
+	copy.AddInt64("wall_time", commandThread->fWallTime);
+	copy.AddInt64("user_time", commandThread->fUserTime);
+	copy.AddInt64("system_time", commandThread->fKernelTime);
+	copy.AddInt64("peak_rss", commandThread->fPeakMemory);
+	if (commandThread->fInputArguments != NULL)
+		copy.AddInt32("input_exit", commandThread->fInputExitCode);
+	commandThread->_Deliver(&copy);
+}
+
+
+#pragma mark -- Private Methods --
+
+
+status_t
+CommandThread::_Deliver(BMessage* message)
+{
+	// Don't block on a full message queue for good, or deleting this
+	// object from the thread of that queue would never return
+	BMessenger messenger = fInvoker->Messenger();
+	status_t status;
+	do {
+		status = messenger.SendMessage(message, fInvoker->HandlerForReply(),
+			kDeliverTimeout);
+	} while ((status == B_TIMED_OUT || status == B_WOULD_BLOCK)
+		&& atomic_get(&fQuitting) == 0);
+
+	return status;
+}
+
+
+void
+CommandThread::_SetChild(thread_id child)
+{
+	AutoLocker<CommandThread> locker(this);
+	fChild = child;
+	if (fChild >= 0) {
+		fStartTime = system_time();
+		fLastSample = 0;
+	}
+
+	// Stop() was called while the command was being started
+	if (fChild >= 0 && atomic_get(&fCanceled) != 0)
+		kill(-fChild, SIGTERM);
+}
+
+
+void
+CommandThread::_SampleUsage(bool force)
+{
+	bigtime_t now = system_time();
+	if (!force && now - fLastSample < kUsageInterval)
+		return;
+	fLastSample = now;
+
+	team_id team;
+	{
+		AutoLocker<CommandThread> locker(this);
+		team = fChild;
+	}
+	if (team < 0)
+		return;
+
+	team_usage_info usage;
+	if (get_team_usage_info(team, B_TEAM_USAGE_SELF, &usage) == B_OK) {
+		fUserTime = usage.user_time;
+		fKernelTime = usage.kernel_time;
+		// Include the commands it started itself that have quit already
+		if (get_team_usage_info(team, B_TEAM_USAGE_CHILDREN, &usage)
+				== B_OK) {
+			fUserTime += usage.user_time;
+			fKernelTime += usage.kernel_time;
+		}
+	}
+
+	// Memory is summed up over all areas of the team, the peak is kept
+	int64 memory = 0;
+	ssize_t cookie = 0;
+	area_info info;
+	while (get_next_area_info(team, &cookie, &info) == B_OK)
+		memory += info.ram_size;
+
+	if (memory > fPeakMemory)
+		fPeakMemory = memory;
+}
+
+
+thread_id
+CommandThread::_SpawnWithInput(BCommandPipe& pipe, FILE** _out, FILE** _err)
+{
+	BCommandPipe input;
+	size_t fifoSize;
+	bool separateStreams;
+	{
+		AutoLocker<CommandThread> locker(this);
+		for (int32 x = 0; x < fInputArguments->CountItems(); x++)
+			input << *fInputArguments->ItemAt(x);
+		fifoSize = fFifoSize;
+		separateStreams = fSeparateStreams;
+	}
+	if (fifoSize == 0)
+		return B_BAD_VALUE;
+
+	input.PrintToStream();
+
+	// The input command writes into "inputPipe", the pump thread moves that
+	// over to "feedPipe", which this command reads from. The stderr of both
+	// is read here.
+	int outPipe[2] = { -1, -1 };
+	int errPipe[2] = { -1, -1 };
+	int inputPipe[2] = { -1, -1 };
+	int feedPipe[2] = { -1, -1 };
+
+	thread_id child = B_ERROR;
+	thread_id inputChild = B_ERROR;
+	if (BCommandPipe::CreatePipe(outPipe) == B_OK
+		&& (!separateStreams || BCommandPipe::CreatePipe(errPipe) == B_OK)
+		&& BCommandPipe::CreatePipe(inputPipe) == B_OK
+		&& BCommandPipe::CreatePipe(feedPipe) == B_OK) {
+		int errWrite = separateStreams ? errPipe[1] : outPipe[1];
+		child = pipe.Spawn(feedPipe[0], outPipe[1], errWrite);
+		if (child >= 0)
+			inputChild = input.Spawn(-1, inputPipe[1], errWrite);
+	}
+
+	// Only the read ends are of use here, and the ends of the pump
+	close(outPipe[1]);
+	close(errPipe[1]);
+	close(inputPipe[1]);
+	close(feedPipe[0]);
+
+	if (inputChild >= 0) {
+		fPumpIn = inputPipe[0];
+		fPumpOut = feedPipe[1];
+		thread_id pump = spawn_thread(CommandThread::_Pump, "fifo pump",
+			B_NORMAL_PRIORITY, this);
+		if (pump >= 0 && resume_thread(pump) == B_OK) {
+			AutoLocker<CommandThread> locker(this);
+			fPumpThread = pump;
+			fInputChild = inputChild;
+
+			// Stop() was called while the commands were being started
+			if (atomic_get(&fCanceled) != 0)
+				kill(-fInputChild, SIGTERM);
+
+			*_out = fdopen(outPipe[0], "r");
+			*_err = separateStreams ? fdopen(errPipe[0], "r") : NULL;
+			return child;
+		}
+		if (pump >= 0)
+			kill_thread(pump);
+	}
+
+	// Something failed, take down what was started already
+	close(inputPipe[0]);
+	close(feedPipe[1]);
+	close(outPipe[0]);
+	close(errPipe[0]);
+
+	int32 signal;
+	if (inputChild >= 0)
+		_Reap(inputChild, true, &signal);
+	if (child >= 0)
+		_Reap(child, true, &signal);
+
+	return B_ERROR;
+}
+
+
+/*static*/ int32
+CommandThread::_Reap(thread_id child, bool terminate, int32* _signal)
+{
+	int status = 0;
+	pid_t result = 0;
+	if (terminate) {
+		// Ask the command to quit, and kill it if it doesn't in time
+		kill(-child, SIGTERM);
+
+		bigtime_t deadline = system_time() + kTerminateTimeout;
+		while ((result = waitpid(child, &status, WNOHANG)) == 0
+			&& system_time() < deadline) {
+			snooze(100000);
+		}
+		if (result == 0)
+			kill(-child, SIGKILL);
+	}
+	if (!terminate || result == 0) {
+		do {
+			result = waitpid(child, &status, 0);
+		} while (result < 0 && errno == EINTR);
+	}
+
+	*_signal = 0;
+	if (result != child)
+		return -1;
+	if (WIFSIGNALED(status)) {
+		// Report it like a shell would
+		*_signal = WTERMSIG(status);
+		return 128 + *_signal;
+	}
+	if (WIFEXITED(status))
+		return WEXITSTATUS(status);
+	return -1;
+}
+
+
+void
+CommandThread::_WaitForChild(thread_id child, bool terminate)
+{
+	// A team's usage can't be looked at anymore once it has quit
+	_SampleUsage(true);
+
+	fExitCode = _Reap(child, terminate, &fExitSignal);
+	fWallTime = system_time() - fStartTime;
+}
+
+
+void
+CommandThread::_WaitForInput(bool terminate)
+{
+	thread_id inputChild;
+	thread_id pump;
+	{
+		AutoLocker<CommandThread> locker(this);
+		inputChild = fInputChild;
+		pump = fPumpThread;
+	}
+
+	if (inputChild >= 0) {
+		int32 signal;
+		fInputExitCode = _Reap(inputChild, terminate, &signal);
+	}
+
+	if (pump >= 0) {
+		// Once the command has quit, nothing reads from the pump anymore;
+		// it gives up on the next write
+		status_t status;
+		wait_for_thread(pump, &status);
+	}
+
+	AutoLocker<CommandThread> locker(this);
+	fInputChild = -1;
 }
@@ -8,11 +8,28 @@
 
 #include "ObjectList.h"
 
+#include <stdio.h>
+
 #include <Invoker.h>
 #include <Locker.h>
 #include <String.h>
 
 
+class CommandReader;
+namespace BPrivate {
+	class BCommandPipe;
+}
+using BPrivate::BCommandPipe;
+
+
+enum command_state {
+	COMMAND_CREATED = 0,
+	COMMAND_RUNNING,
+	COMMAND_EXITED,
+	COMMAND_CANCELED
+};
+
+
 class CommandThread : public BLocker {
 public:
 					CommandThread(BObjectList<BString>* argList = NULL,
@@ -26,18 +43,78 @@ public:
 	BInvoker* 		Invoker();
 	void 			SetInvoker(BInvoker* invoker);
 
+	// Time without output after which a "stalled" message is sent, again
+	// and again, until there's output or the command is stopped.
+	bigtime_t		Timeout();
+	void			SetTimeout(bigtime_t timeout);
+
+	// Reads stdout and stderr of the command separately, and tags each line
+	// with the stream it came from. By default both are read as one.
+	bool			SeparateStreams();
+	void			SetSeparateStreams(bool separate);
+
+	// Runs another command along with this one, and feeds its output into
+	// the stdin of this one, through an in-process fifo of "fifoSize"
+	// bytes. Its stderr is read along with the one of this command. Takes
+	// ownership of "arguments".
+	// The fill level of the fifo (0 to 100) is sent as "fifo_fill" while
+	// the commands run, and the exit code of the input command as
+	// "input_exit" when they are done.
+	void			SetInputCommand(BObjectList<BString>* arguments,
+						size_t fifoSize = 16 * 1024 * 1024);
+
+	// Run() fails with B_BUSY while the command is still running. The
+	// destructor stops a running command, and waits for it to quit.
 	status_t 		Run();
 	status_t 		Stop();
 	status_t 		Wait();
 	bool 			IsRunning();
+	command_state	State();
 
 private:
+	friend class CommandReader;
+
 	static int32 	_Thread(void* data);
 	static void 	_ThreadExit(void* data);
+	static int32	_Pump(void* data);
+
+	thread_id		_SpawnWithInput(BCommandPipe& pipe, FILE** _out,
+						FILE** _err);
+	static int32	_Reap(thread_id child, bool terminate, int32* _signal);
+
+	status_t		_Deliver(BMessage* message);
+	void			_SetChild(thread_id child);
+	void			_SampleUsage(bool force = false);
+	void			_WaitForChild(thread_id child, bool terminate);
+	void			_WaitForInput(bool terminate);
 
 	BObjectList<BString>* fArgumentList;
 	BInvoker* 		fInvoker;
 	thread_id 		fThread;
+	thread_id		fChild;
+	bigtime_t		fTimeout;
+	bool			fSeparateStreams;
+	int32			fState;
+	int32			fCanceled;
+	int32			fQuitting;
+
+	int32			fExitCode;
+	int32			fExitSignal;
+	bigtime_t		fStartTime;
+	bigtime_t		fLastSample;
+	bigtime_t		fWallTime;
+	bigtime_t		fUserTime;
+	bigtime_t		fKernelTime;
+	int64			fPeakMemory;
+
+	BObjectList<BString>* fInputArguments;
+	size_t			fFifoSize;
+	thread_id		fInputChild;
+	thread_id		fPumpThread;
+	int				fPumpIn;
+	int				fPumpOut;
+	int32			fFifoFill;
+	int32			fInputExitCode;
 };
 
 
@@ -53,11 +53,9 @@ CompilationAudioView::CompilationAudioView(BurnWindow& parent)
 	fInfoView->SetLabel(B_TRANSLATE_COMMENT("Ready",
 		"Status notification"));
 
-	fOutputView = new BTextView("AudioInfoTextView");
-	fOutputView->SetWordWrap(true);
-	fOutputView->MakeEditable(false);
+	fOutputView = new LogView("AudioInfoTextView");
 	BScrollView* fOutputScrollView = new BScrollView("AudioInfoScrollView",
-		fOutputView, B_WILL_DRAW, false, true);
+		fOutputView, B_WILL_DRAW, true, true);
 	fOutputScrollView->SetExplicitMinSize(BSize(B_SIZE_UNSET, 64));
 
 	fBurnButton = new BButton("BurnDiscButton", B_TRANSLATE_COMMENT("Burn disc",
@@ -414,7 +412,7 @@ CompilationAudioView::_Burn()
 	fAction = BURNING;	// flag we're burning
 	fBurnButton->SetEnabled(false);
 
-	fOutputView->SetText(NULL);
+	fOutputView->Clear();
 	fInfoView->SetLabel(B_TRANSLATE_COMMENT("Burning in progress"
 		B_UTF8_ELLIPSIS, "Status notification"));
 
@@ -437,8 +435,13 @@ CompilationAudioView::_Burn()
 	device.Append(fWindowParent->GetSelectedDevice().number.String());
 	sessionConfig config = fWindowParent->GetSessionConfig();
 
+	if (fBurnerThread != NULL)
+		delete fBurnerThread;
+
 	fBurnerThread = new CommandThread(NULL,
 		new BInvoker(new BMessage(kBurnOutput), this));
+	fBurnerThread->SetSeparateStreams(true);
+	fBurnerThread->SetTimeout(kCdrecordTimeout);
 
 	fBurnerThread->AddArgument("cdrecord");
 
@@ -489,24 +492,26 @@ CompilationAudioView::_BurnOutput(BMessage* message)
 {
 	BString data;
 
-	if (message->FindString("line", &data) == B_OK) {
-		BString text = fOutputView->Text();
-		int32 modified = fParser.ParseCdrecordLine(text, data);
-		if (modified < 0)
-			fAbort = modified;
-		if (modified <= 0) {
-			data << "\n";
-			fOutputView->Insert(data.String());
-			fOutputView->ScrollBy(0.0, 50.0);
-		} else {
-			if (modified == PERCENT)
-				_UpdateProgress();
-			fOutputView->SetText(text);
-			fOutputView->ScrollTo(0.0, 1000000.0);
-		}
+	for (int32 i = 0; message->FindString("line", i, &data) == B_OK; i++) {
+		int32 stream = -1;
+		message->FindInt32("stream", i, &stream);
+
+		ParseEvent event = fParser.ParseCdrecordLine(data, stream);
+		if (event.result < 0)
+			fAbort = event.result;
+		else if (event.result == PERCENT)
+			_UpdateProgress();
+		fOutputView->AddLine(data, event.replaceLine);
+		ShowBufferFill(event, fParser.Buffers(), fSizeView, fOutputView);
 	}
+	if (StopStalled(message, fBurnerThread, fOutputView))
+		fAbort = STALLED;
+
 	int32 code = -1;
 	if (message->FindInt32("thread_exit", &code) == B_OK) {
+		// Whatever progress was held back goes before the final notification
+		fProgressController.Flush();
+
 		if (fAbort == SMALLDISC) {
 			fInfoView->SetLabel(B_TRANSLATE_COMMENT(
 				"Burning aborted: The data doesn't fit on the disc",
@@ -533,6 +538,19 @@ CompilationAudioView::_BurnOutput(BMessage* message)
 				"Some WAV file has the wrong encoding", "Notification content"));
 			burnAbort.SetMessageID(fNoteID);
 			burnAbort.Send();
+		} else if (fAbort == STALLED) {
+			fInfoView->SetLabel(B_TRANSLATE_COMMENT(
+				"Burning aborted: The burner stopped responding",
+				"Status notification"));
+
+			BNotification burnAbort(B_IMPORTANT_NOTIFICATION);
+			burnAbort.SetGroup("BurnItNow");
+			burnAbort.SetTitle(B_TRANSLATE_COMMENT("Burning aborted",
+				"Notification title"));
+			burnAbort.SetContent(B_TRANSLATE_COMMENT(
+				"The burner stopped responding.", "Notification content"));
+			burnAbort.SetMessageID(fNoteID);
+			burnAbort.Send();
 		} else {
 			fInfoView->SetLabel(B_TRANSLATE_COMMENT(
 				"Burning finished. Burn another disc?",
@@ -552,6 +570,10 @@ CompilationAudioView::_BurnOutput(BMessage* message)
 
 		fAction = IDLE;
 		fAbort = 0;
+		fSizeView->HideBufferFill();
+		BString summary = BufferSummary(fParser.Buffers());
+		if (!summary.IsEmpty())
+			fOutputView->AddLine(summary);
 		fParser.Reset();
 	}
 }
@@ -585,14 +607,9 @@ CompilationAudioView::_UpdateButtons()
 void
 CompilationAudioView::_UpdateProgress()
 {
-	BNotification burnProgress(B_PROGRESS_NOTIFICATION);
-	burnProgress.SetGroup("BurnItNow");
-	burnProgress.SetTitle(B_TRANSLATE_COMMENT("Burning Audio CD",
-		"Notification title"));
-	burnProgress.SetContent(fETAtime);
-	burnProgress.SetProgress(fProgress);
-	burnProgress.SetMessageID(fNoteID);
-	burnProgress.Send();
+	fProgressController.Update(fNoteID,
+		B_TRANSLATE_COMMENT("Burning Audio CD", "Notification title"),
+		fETAtime, fProgress);
 }
 
 
@@ -11,12 +11,13 @@
 #include <Path.h>
 #include <SeparatorView.h>
 #include <SplitView.h>
-#include <TextView.h>
 #include <View.h>
 
 #include "AudioList.h"
 #include "BurnWindow.h"
+#include "LogView.h"
 #include "OutputParser.h"
+#include "ProgressController.h"
 #include "SizeView.h"
 
 #define MAX_TRACKS 255
@@ -58,7 +59,7 @@ private:
 	BurnWindow* 	fWindowParent;
 
 	BFilePanel* 	fOpenPanel;
-	BTextView* 		fOutputView;
+	LogView* 		fOutputView;
 	BSeparatorView*	fInfoView;
 	BSeparatorView*	fAudioBox;
 	BButton*		fBurnButton;
@@ -76,6 +77,7 @@ private:
 	int32			fID;
 	float			fProgress;
 	BString			fETAtime;
+	ProgressController fProgressController;
 	OutputParser	fParser;
 
 	int32			fAbort;
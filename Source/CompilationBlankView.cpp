@@ -43,9 +43,7 @@ CompilationBlankView::CompilationBlankView(BurnWindow& parent)
 	fInfoView->SetLabel(B_TRANSLATE_COMMENT(
 	"Insert the disc and blank it", "Status notification"));
 
-	fOutputView = new BTextView("OutputView");
-	fOutputView->SetWordWrap(false);
-	fOutputView->MakeEditable(false);
+	fOutputView = new LogView("OutputView");
 	BScrollView* fOutputScrollView = new BScrollView("OutputScroller",
 		fOutputView, B_WILL_DRAW, true, true);
 	fOutputScrollView->SetExplicitMinSize(BSize(B_SIZE_UNSET, 64));
@@ -170,7 +168,7 @@ CompilationBlankView::_Blank()
 	int32 menuIndex = fBlankModeMenu->IndexOf(fBlankModeMenu->FindMarked());
 	mode.Append(kBlankMode[menuIndex]);
 
-	fOutputView->SetText(NULL);
+	fOutputView->Clear();
 	fInfoView->SetLabel(B_TRANSLATE_COMMENT("Blanking in progress"
 		B_UTF8_ELLIPSIS, "Status notification"));
 
@@ -197,6 +195,9 @@ CompilationBlankView::_Blank()
 	device.Append(fWindowParent->GetSelectedDevice().number.String());
 	sessionConfig config = fWindowParent->GetSessionConfig();
 
+	if (fBlankerThread != NULL)
+		delete fBlankerThread;
+
 	fBlankerThread = new CommandThread(NULL,
 		new BInvoker(new BMessage(kBlankOutput), this));
 
@@ -218,10 +219,8 @@ CompilationBlankView::_BlankOutput(BMessage* message)
 {
 	BString data;
 
-	if (message->FindString("line", &data) == B_OK) {
-		data << "\n";
-		fOutputView->Insert(data.String());
-		fOutputView->ScrollBy(0.0, 50.0);
+	for (int32 i = 0; message->FindString("line", i, &data) == B_OK; i++) {
+		fOutputView->AddLine(data);
 	}
 	int32 code = -1;
 	if (message->FindInt32("thread_exit", &code) == B_OK) {
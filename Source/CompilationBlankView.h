@@ -9,10 +9,10 @@
 #include <FilePanel.h>
 #include <Menu.h>
 #include <SeparatorView.h>
-#include <TextView.h>
 #include <View.h>
 
 #include "BurnWindow.h"
+#include "LogView.h"
 
 
 
@@ -36,7 +36,7 @@ private:
 	CommandThread*	fBlankerThread;
 	BurnWindow*		fWindowParent;
 
-	BTextView*		fOutputView;
+	LogView*		fOutputView;
 	BSeparatorView*	fInfoView;
 	BMenu*			fBlankModeMenu;
 	BButton*		fBlankButton;
@@ -23,6 +23,7 @@
 #include "CompilationCloneView.h"
 #include "CompilationShared.h"
 #include "Constants.h"
+#include "JobPipeline.h"
 #include "OutputParser.h"
 
 #undef B_TRANSLATION_CONTEXT
@@ -32,12 +33,162 @@
 // Misc variables
 int selectedSrcDevice;
 
+// The stages of building a clone image
+enum {
+	kMediaInfoStage = 0,
+	kReadStage,
+	kEjectStage
+};
+
+
+class MediaInfoStage : public JobStage {
+public:
+	MediaInfoStage(const BString& device)
+	:
+	JobStage("media-info", 1.0f, kCdrecordTimeout),
+	fDevice(device),
+	fImageSize(0),
+	fProgress(0),
+	fParser(fProgress, fETAtime) {}
+
+
+	virtual status_t Prepare(CommandThread* thread, const BMessage& results)
+	{
+		thread->AddArgument("cdrecord")
+			->AddArgument("-media-info")
+			->AddArgument(fDevice);
+		return B_OK;
+	}
+
+	virtual float ParseLine(const BString& line, int32 stream,
+		BMessage& results)
+	{
+		fParser.ParseMediainfoLine(fImageSize, line);
+		fOutput << line << "\n";
+		return -1.0f;
+	}
+
+	virtual status_t Finish(int32 exitCode, BMessage& results)
+	{
+		if (exitCode != 0)
+			return B_ERROR;
+
+		BStringList output;
+		BStringList wordList;
+		fOutput.Split("==============================================", true,
+			output);
+		output.StringAt(1).Split(" ", true, wordList);
+
+		results.AddInt64("image_size", fImageSize);
+		results.AddBool("audio", wordList.StringAt(3) == "Audio");
+		return B_OK;
+	}
+
+private:
+	BString			fDevice;
+	BString			fOutput;
+	int64			fImageSize;
+	float			fProgress;
+	BString			fETAtime;
+	OutputParser	fParser;
+};
+
+
+class ReadDiscStage : public JobStage {
+public:
+	ReadDiscStage(const BString& device, const BPath& cacheFolder)
+	:
+	JobStage("readcd", 18.0f, kReadcdTimeout),
+	fDevice(device),
+	fCacheFolder(cacheFolder),
+	fProgress(0),
+	fParser(fProgress, fETAtime) {}
+
+
+	virtual status_t Prepare(CommandThread* thread, const BMessage& results)
+	{
+		// TODO: Audio discs would be read in with cdda2wav, which currently
+		// fails with the error message
+		//   "cdda2wav: Invalid Argument. Cannot open output fd 0"
+		// if BurnItNow isn't started from Terminal.
+		// Maybe an issue with environment variables in Haiku in general?
+		// See https://dev.haiku-os.org/ticket/12534
+		if (results.GetBool("audio", false))
+			return B_NOT_SUPPORTED;
+
+		int64 imageSize = results.GetInt64("image_size", 0);
+		if (!CheckFreeSpace(imageSize * 1024, fCacheFolder.Path()))
+			return B_DEVICE_FULL;
+
+		BPath path(fCacheFolder);
+		status_t ret = path.Append(kCacheFileClone);
+		if (ret != B_OK)
+			return ret;
+
+		BString file = "f=";
+		file.Append(path.Path());
+
+		thread->AddArgument("readcd")
+			->AddArgument(fDevice)
+			->AddArgument("-s")
+			->AddArgument("speed=10")	// for max compatibility
+			->AddArgument(file);
+		return B_OK;
+	}
+
+	virtual float ParseLine(const BString& line, int32 stream,
+		BMessage& results)
+	{
+		ParseEvent event = fParser.ParseReadcdLine(line);
+		if (event.result == PERCENT)
+			return event.progress;
+
+		return -1.0f;
+	}
+
+private:
+	BString			fDevice;
+	BPath			fCacheFolder;
+	float			fProgress;
+	BString			fETAtime;
+	OutputParser	fParser;
+};
+
+
+class EjectStage : public JobStage {
+public:
+	EjectStage(const BString& device)
+	:
+	JobStage("eject", 1.0f, kCdrecordTimeout),
+	fDevice(device) {}
+
+
+	virtual status_t Prepare(CommandThread* thread, const BMessage& results)
+	{
+		thread->AddArgument("cdrecord")
+			->AddArgument("-eject")
+			->AddArgument(fDevice);
+		return B_OK;
+	}
+
+	virtual status_t Finish(int32 exitCode, BMessage& results)
+	{
+		// The image is fine, even if the disc couldn't be ejected
+		return B_OK;
+	}
+
+private:
+	BString			fDevice;
+};
+
+
 
 CompilationCloneView::CompilationCloneView(BurnWindow& parent)
 	:
 	BView(B_TRANSLATE_COMMENT("Clone disc", "Tab label"), B_WILL_DRAW,
 		new BGroupLayout(B_VERTICAL, kControlPadding)),
 	fBurnerThread(NULL),
+	fPipeline(NULL),
 	fOpenPanel(NULL),
 	fImageSize(0),
 	fNoteID(""),
@@ -59,9 +210,7 @@ CompilationCloneView::CompilationCloneView(BurnWindow& parent)
 		"Insert the disc and create an image",
 		"Status notification"));
 
-	fOutputView = new BTextView("OutputView");
-	fOutputView->SetWordWrap(false);
-	fOutputView->MakeEditable(false);
+	fOutputView = new LogView("OutputView");
 	BScrollView* fOutputScrollView = new BScrollView("OutputScroller",
 		fOutputView, B_WILL_DRAW, true, true);
 	fOutputScrollView->SetExplicitMinSize(BSize(B_SIZE_UNSET, 64));
@@ -101,6 +250,8 @@ CompilationCloneView::CompilationCloneView(BurnWindow& parent)
 CompilationCloneView::~CompilationCloneView()
 {
 	delete fBurnerThread;
+	if (fPipeline != NULL)
+		fPipeline->PostMessage(B_QUIT_REQUESTED);
 	delete fOpenPanel;
 }
 
@@ -126,7 +277,7 @@ CompilationCloneView::MessageReceived(BMessage* message)
 {
 	switch (message->what) {
 		case kBuildButton:
-			_GetImageInfo();
+			_Build();
 			break;
 		case kBuildOutput:
 			_BuildOutput(message);
@@ -137,9 +288,6 @@ CompilationCloneView::MessageReceived(BMessage* message)
 		case kBurnOutput:
 			_BurnOutput(message);
 			break;
-		case kGetImageInfoOutput:
-			_GetImageInfoOutput(message);
-			break;
 		default:
 		if (kDeviceChange[0] == message->what) {
 			selectedSrcDevice = 0;
@@ -187,84 +335,35 @@ CompilationCloneView::_Build()
 	if (path.InitCheck() != B_OK)
 		return;
 
-	if (!CheckFreeSpace(fImageSize * 1024, path.Path())) {
-		fBuildButton->SetEnabled(true);
-		return;
-	}
-
-	if (fAudioMode == true) {
-		BString text(B_TRANSLATE(
-			"BurnItNow currently only supports the cloning of data discs.\n\n"
-			"You can mount the audio disc with Tracker, copy the WAV files "
-			"to your hard disk and burn them with BurnItNow in 'Audio CD' "
-			"mode."));
-		(new BAlert("NoAudioCloning", text, B_TRANSLATE("OK")))->Go();
-
-		fBuildButton->SetEnabled(true);
-		return;
-
-	// TODO: cdda2wav currently fails with the error message
-	//   "cdda2wav: Invalid Argument. Cannot open output fd 0"
-	// if BurnItNow isn't started from Terminal.
-	// Maybe an issue with environment variables in Haiku in general?
-	// See https://dev.haiku-os.org/ticket/12534
-
-		BDirectory folder(path.Path());
-		status_t ret = folder.CreateDirectory(kCacheFolderAudioClone, NULL);
-		if (!(ret == B_FILE_EXISTS || ret == B_OK))
-			return;
-
-		ret = path.Append(kCacheFolderAudioClone);
-		if (ret == B_OK) {
-			fAction = BUILDING;
-			fBuildButton->SetEnabled(false);
+	fImageSize = 0;
+	fAudioMode = false;
+	fAction = BUILDING;
+	fBuildButton->SetEnabled(false);
+	fOutputView->Clear();
 
-			fOutputView->SetText(NULL);
-			fInfoView->SetLabel(B_TRANSLATE_COMMENT(
-				"Reading in WAV files" B_UTF8_ELLIPSIS, "Status notification"));
+	BString device("dev=");
+	device.Append(fWindowParent->GetSelectedDevice().number.String());
 
-			BNotification buildProgress(B_PROGRESS_NOTIFICATION);
-			buildProgress.SetGroup("BurnItNow");
-			buildProgress.SetTitle(B_TRANSLATE_COMMENT("Cloning Audio CD",
-				"Notification title"));
-			buildProgress.SetContent(B_TRANSLATE_COMMENT(
-				"Reading in WAV files" B_UTF8_ELLIPSIS, "Notification content"));
-			buildProgress.SetProgress(0);
+	// Find out about the disc, read it in and eject it, without the window
+	// having to start each step
+	if (fPipeline != NULL)
+		fPipeline->PostMessage(B_QUIT_REQUESTED);
 
-			char id[5];
-			snprintf(id, sizeof(id), "%" B_PRId32, fID++); // new ID
-			fNoteID = "BurnItNow_Clone-";
-			fNoteID.Append(id);
+	fPipeline = new JobPipeline(new BInvoker(new BMessage(kBuildOutput), this));
+	fPipeline->AddStage(new MediaInfoStage(device));
+	fPipeline->AddStage(new ReadDiscStage(device, path));
+	fPipeline->AddStage(new EjectStage(device));
+	fPipeline->Start();
+}
 
-			buildProgress.SetMessageID(fNoteID);
-			buildProgress.Send();
 
-			BString wavPath(path.Path());
-			wavPath.Append("/");
-
-			BString device("dev=");
-			device.Append(fWindowParent->GetSelectedDevice().number.String());
-			sessionConfig config = fWindowParent->GetSessionConfig();
-
-			fBurnerThread = new CommandThread(NULL,
-				new BInvoker(new BMessage(kBuildOutput), this));
-			fBurnerThread->AddArgument("cdda2wav")
-				->AddArgument(device)
-				->AddArgument("paraopts=proof")
-				->AddArgument("-vall")
-				->AddArgument("cddb=0")
-				->AddArgument("-B")
-				->AddArgument("-Owav")
-				->AddArgument(wavPath)
-				->Run();
-		}
-	} else {
-		status_t ret = path.Append(kCacheFileClone);
-		if (ret == B_OK) {
-			fAction = BUILDING;
-			fBuildButton->SetEnabled(false);
+void
+CompilationCloneView::_BuildOutput(BMessage* message)
+{
+	int32 stage = -1;
 
-			fOutputView->SetText(NULL);
+	if (message->FindInt32("stage_start", &stage) == B_OK) {
+		if (stage == kReadStage) {
 			fInfoView->SetLabel(B_TRANSLATE_COMMENT(
 				"Reading in disc" B_UTF8_ELLIPSIS, "Status notification"));
 
@@ -283,77 +382,86 @@ CompilationCloneView::_Build()
 
 			buildProgress.SetMessageID(fNoteID);
 			buildProgress.Send();
+		}
+		return;
+	}
 
-			BString file = "f=";
-			file.Append(path.Path());
-			BString device("dev=");
-			device.Append(fWindowParent->GetSelectedDevice().number.String());
-			sessionConfig config = fWindowParent->GetSessionConfig();
-
-			fBurnerThread = new CommandThread(NULL,
-				new BInvoker(new BMessage(kBuildOutput), this));
-			fBurnerThread->AddArgument("readcd")
-				->AddArgument(device)
-				->AddArgument("-s")
-				->AddArgument("speed=10")	// for max compatibility
-				->AddArgument(file)
-				->Run();
+	if (message->FindInt32("stage_done", &stage) == B_OK) {
+		BMessage results;
+		if (stage == kMediaInfoStage
+			&& message->FindMessage("results", &results) == B_OK) {
+			fImageSize = results.GetInt64("image_size", 0);
+			fAudioMode = results.GetBool("audio", false);
+			if (fImageSize != 0)
+				fSizeView->UpdateSizeDisplay(fImageSize, DATA, CD_OR_DVD);
 		}
+		return;
 	}
-}
 
+	message->FindInt32("stage", &stage);
+	StopStalled(message, NULL, fOutputView);
 
-void
-CompilationCloneView::_BuildOutput(BMessage* message)
-{
 	BString data;
-
-	if (message->FindString("line", &data) == B_OK) {
-		BString text = fOutputView->Text();
-		int32 modified = fParser.ParseReadcdLine(text, data);
-		if (modified == NOCHANGE) {
-			data << "\n";
-			fOutputView->Insert(data.String());
-			fOutputView->ScrollBy(0.0, 50.0);
-		} else {
-			if (modified == PERCENT) {
-				_UpdateProgress(B_TRANSLATE_COMMENT("Building clone image",
-					"Notification title"));
+	for (int32 i = 0; message->FindString("line", i, &data) == B_OK; i++) {
+		ParseEvent event;
+		if (stage == kReadStage)
+			event = fParser.ParseReadcdLine(data);
+		if (event.result == PERCENT) {
+			// the progress of the whole pipeline
+			message->FindFloat("progress", &fProgress);
+			// Checking the size of the image isn't worth it more often
+			if (_UpdateProgress(B_TRANSLATE_COMMENT("Building clone image",
+					"Notification title")))
 				_UpdateSizeBar();
-			}
-			fOutputView->SetText(text);
-			fOutputView->ScrollTo(0.0, 1000000.0);
 		}
+		fOutputView->AddLine(data, event.replaceLine);
 	}
-	int32 code = -1;
-	if (message->FindInt32("thread_exit", &code) == B_OK) {
-		fInfoView->SetLabel(B_TRANSLATE_COMMENT(
-			"Insert a blank disc and burn it",
-			"Status notification"));
 
-		BNotification buildSuccess(B_INFORMATION_NOTIFICATION);
-		buildSuccess.SetGroup("BurnItNow");
-		buildSuccess.SetTitle(B_TRANSLATE_COMMENT("Building clone image",
-			"Notification title"));
-		buildSuccess.SetContent(B_TRANSLATE_COMMENT("Building finished!",
-			"Notification content"));
-		buildSuccess.SetMessageID(fNoteID);
-		buildSuccess.Send();
+	status_t status;
+	if (message->FindInt32("pipeline_exit", &status) == B_OK) {
+		if (fProgressController.Flush())
+			_UpdateSizeBar();
 
-		BString device("dev=");
-		device.Append(fWindowParent->GetSelectedDevice().number.String());
+		if (status == B_OK) {
+			fInfoView->SetLabel(B_TRANSLATE_COMMENT(
+				"Insert a blank disc and burn it",
+				"Status notification"));
 
-		fBurnerThread = new CommandThread(NULL,
-			new BInvoker(new BMessage(), this)); // no need for notification
-		fBurnerThread->AddArgument("cdrecord")
-			->AddArgument("-eject")
-			->AddArgument(device)
-			->Run();
+			BNotification buildSuccess(B_INFORMATION_NOTIFICATION);
+			buildSuccess.SetGroup("BurnItNow");
+			buildSuccess.SetTitle(B_TRANSLATE_COMMENT("Building clone image",
+				"Notification title"));
+			buildSuccess.SetContent(B_TRANSLATE_COMMENT("Building finished!",
+				"Notification content"));
+			buildSuccess.SetMessageID(fNoteID);
+			buildSuccess.Send();
+
+			fBurnButton->SetEnabled(true);
+		} else if (status == B_NOT_SUPPORTED && stage == kReadStage) {
+			BString text(B_TRANSLATE(
+				"BurnItNow currently only supports the cloning of data discs."
+				"\n\nYou can mount the audio disc with Tracker, copy the WAV "
+				"files to your hard disk and burn them with BurnItNow in "
+				"'Audio CD' mode."));
+			(new BAlert("NoAudioCloning", text, B_TRANSLATE("OK")))->Go();
+		} else if (status == B_TIMED_OUT) {
+			fInfoView->SetLabel(stage == kReadStage
+				? B_TRANSLATE_COMMENT(
+					"Unable to create a clone image: Reading the disc hung",
+					"Status notification")
+				: B_TRANSLATE_COMMENT(
+					"Unable to create a clone image: The drive hung",
+					"Status notification"));
+		} else if (status != B_DEVICE_FULL) {
+			// CheckFreeSpace() has told about a full disk already
+			fInfoView->SetLabel(B_TRANSLATE_COMMENT(
+				"Unable to create a clone image",
+				"Status notification"));
+		}
 
 		fBuildButton->SetEnabled(true);
-		fBurnButton->SetEnabled(true);
-
 		fAction = IDLE;
+		fParser.Reset();
 	}
 }
 
@@ -410,7 +518,7 @@ CompilationCloneView::_Burn()
 	fBuildButton->SetEnabled(false);
 	fBurnButton->SetEnabled(false);
 
-	fOutputView->SetText(NULL);
+	fOutputView->Clear();
 	fInfoView->SetLabel(B_TRANSLATE_COMMENT(
 		"Burning in progress" B_UTF8_ELLIPSIS, "Status notification"));
 
@@ -432,8 +540,13 @@ CompilationCloneView::_Burn()
 	device.Append(fWindowParent->GetSelectedDevice().number.String());
 	sessionConfig config = fWindowParent->GetSessionConfig();
 
+	if (fBurnerThread != NULL)
+		delete fBurnerThread;
+
 	fBurnerThread = new CommandThread(NULL,
 		new BInvoker(new BMessage(kBurnOutput), this));
+	fBurnerThread->SetSeparateStreams(true);
+	fBurnerThread->SetTimeout(kCdrecordTimeout);
 	fBurnerThread->AddArgument("cdrecord");
 
 	if (config.simulation)
@@ -476,25 +589,26 @@ CompilationCloneView::_BurnOutput(BMessage* message)
 {
 	BString data;
 
-	if (message->FindString("line", &data) == B_OK) {
-		BString text = fOutputView->Text();
-		int32 modified = fParser.ParseCdrecordLine(text, data);
-		if (modified < 0)
-			fAbort = modified;
-		if (modified <= 0) {
-			data << "\n";
-			fOutputView->Insert(data.String());
-			fOutputView->ScrollBy(0.0, 50.0);
-		} else {
-			if (modified == PERCENT)
-				_UpdateProgress(B_TRANSLATE_COMMENT("Burning clone disc",
-				"Notification title"));
-			fOutputView->SetText(text);
-			fOutputView->ScrollTo(0.0, 1000000.0);
-		}
+	for (int32 i = 0; message->FindString("line", i, &data) == B_OK; i++) {
+		int32 stream = -1;
+		message->FindInt32("stream", i, &stream);
+
+		ParseEvent event = fParser.ParseCdrecordLine(data, stream);
+		if (event.result < 0)
+			fAbort = event.result;
+		else if (event.result == PERCENT)
+			_UpdateProgress(B_TRANSLATE_COMMENT("Burning clone disc",
+			"Notification title"));
+		fOutputView->AddLine(data, event.replaceLine);
+		ShowBufferFill(event, fParser.Buffers(), fSizeView, fOutputView);
 	}
+	if (StopStalled(message, fBurnerThread, fOutputView))
+		fAbort = STALLED;
+
 	int32 code = -1;
 	if (message->FindInt32("thread_exit", &code) == B_OK) {
+		fProgressController.Flush();
+
 		if (fAbort == SMALLDISC) {
 			fInfoView->SetLabel(B_TRANSLATE_COMMENT(
 				"Burning aborted: The data doesn't fit on the disc",
@@ -508,6 +622,19 @@ CompilationCloneView::_BurnOutput(BMessage* message)
 				"The data doesn't fit on the disc.", "Notification content"));
 			burnAbort.SetMessageID(fNoteID);
 			burnAbort.Send();
+		} else if (fAbort == STALLED) {
+			fInfoView->SetLabel(B_TRANSLATE_COMMENT(
+				"Burning aborted: The burner stopped responding",
+				"Status notification"));
+
+			BNotification burnAbort(B_IMPORTANT_NOTIFICATION);
+			burnAbort.SetGroup("BurnItNow");
+			burnAbort.SetTitle(B_TRANSLATE_COMMENT("Burning aborted",
+				"Notification title"));
+			burnAbort.SetContent(B_TRANSLATE_COMMENT(
+				"The burner stopped responding.", "Notification content"));
+			burnAbort.SetMessageID(fNoteID);
+			burnAbort.Send();
 		} else {
 			fInfoView->SetLabel(B_TRANSLATE_COMMENT(
 				"Burning complete. Burn another disc?",
@@ -528,76 +655,19 @@ CompilationCloneView::_BurnOutput(BMessage* message)
 
 		fAction = IDLE;
 		fAbort = 0;
+		fSizeView->HideBufferFill();
+		BString summary = BufferSummary(fParser.Buffers());
+		if (!summary.IsEmpty())
+			fOutputView->AddLine(summary);
 		fParser.Reset();
 	}
 }
 
 
-void
-CompilationCloneView::_GetImageInfo()
-{
-	fImageSize = 0;
-	fOutputView->SetText(NULL);
-	fBuildButton->SetEnabled(false);
-
-	BString device("dev=");
-	device.Append(fWindowParent->GetSelectedDevice().number.String());
-	sessionConfig config = fWindowParent->GetSessionConfig();
-
-	fBurnerThread = new CommandThread(NULL,
-		new BInvoker(new BMessage(kGetImageInfoOutput), this));
-	fBurnerThread->AddArgument("cdrecord")
-		->AddArgument("-media-info")
-		->AddArgument(device)
-		->Run();
-}
-
-
-void
-CompilationCloneView::_GetImageInfoOutput(BMessage* message)
-{
-	BString data;
-
-	if (message->FindString("line", &data) == B_OK) {
-		fParser.ParseMediainfoLine(fImageSize, data);
-//		printf("Image size forecast: %" PRId64 " KiB, %" PRId64 " MiB\n",
-//			fImageSize, fImageSize / 1024);
-
-		if (fImageSize != 0)
-			fSizeView->UpdateSizeDisplay(fImageSize, DATA, CD_OR_DVD);
-
-		data << "\n";
-		fOutputView->Insert(data.String());
-		fOutputView->ScrollBy(0.0, 50.0);
-	}
-	int32 code = -1;
-	if (message->FindInt32("thread_exit", &code) == B_OK) {
-		BString text = fOutputView->Text();
-		BStringList output;
-		BStringList wordList;
-		text.Split("==============================================", true, 
-			output);
-		output.StringAt(1).Split(" ", true, wordList);
-		if (wordList.StringAt(3) == "Audio")
-			fAudioMode = true;
-		else
-			fAudioMode = false;
-
-		_Build();
-	}
-}
-
-
-void
+bool
 CompilationCloneView::_UpdateProgress(const char* title)
 {
-	BNotification burnProgress(B_PROGRESS_NOTIFICATION);
-	burnProgress.SetGroup("BurnItNow");
-	burnProgress.SetTitle(title);
-	burnProgress.SetContent(fETAtime);
-	burnProgress.SetProgress(fProgress);
-	burnProgress.SetMessageID(fNoteID);
-	burnProgress.Send();
+	return fProgressController.Update(fNoteID, title, fETAtime, fProgress);
 }
 
 
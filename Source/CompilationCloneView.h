@@ -9,15 +9,17 @@
 #include <FilePanel.h>
 #include <Menu.h>
 #include <SeparatorView.h>
-#include <TextView.h>
 #include <View.h>
 
 #include "BurnWindow.h"
+#include "LogView.h"
 #include "OutputParser.h"
+#include "ProgressController.h"
 #include "SizeView.h"
 
 
 class CommandThread;
+class JobPipeline;
 
 
 class CompilationCloneView : public BView {
@@ -35,16 +37,15 @@ private:
 	void 			_BuildOutput(BMessage* message);
 	void 			_Burn();
 	void 			_BurnOutput(BMessage* message);
-	void 			_GetImageInfo();
-	void 			_GetImageInfoOutput(BMessage* message);
-	void			_UpdateProgress(const char* title);
+	bool			_UpdateProgress(const char* title);
 	void			_UpdateSizeBar();
 
 	CommandThread*	fBurnerThread;
+	JobPipeline*	fPipeline;
 	BurnWindow*		fWindowParent;
 
 	BFilePanel*		fOpenPanel;
-	BTextView*		fOutputView;
+	LogView*		fOutputView;
 	BSeparatorView*	fInfoView;
 	BButton*		fBurnButton;
 	BButton*		fBuildButton;
@@ -56,6 +57,7 @@ private:
 	int32			fID;
 	float			fProgress;
 	BString			fETAtime;
+	ProgressController fProgressController;
 	OutputParser	fParser;
 
 	int32			fAbort;
@@ -21,6 +21,9 @@
 #include "CommandThread.h"
 #include "CompilationShared.h"
 #include "Constants.h"
+#include "FolderSizeIndex.h"
+#include "JobPipeline.h"
+#include "MultiBurner.h"
 
 
 #undef B_TRANSLATION_CONTEXT
@@ -32,17 +35,33 @@ CompilationDVDView::CompilationDVDView(BurnWindow& parent)
 	BView(B_TRANSLATE("Audio/Video DVD"), B_WILL_DRAW,
 		new BGroupLayout(B_VERTICAL, kControlPadding)),
 	fBurnerThread(NULL),
+	fPipeline(NULL),
+	fFitPipeline(NULL),
+	fMultiBurner(NULL),
 	fOpenPanel(NULL),
 	fDirPath(new BPath()),
 	fImagePath(new BPath()),
 	fFolderSize(0),
+	fCountingSize(false),
+	fSizeWatched(true),
+	fSizeRecounted(false),
+	fBuildWaiting(false),
+	fSizeIndex(NULL),
+	fSizePipeline(NULL),
+	fSizeGeneration(0),
+	fPredicting(false),
+	fPredictAfterCount(false),
+	fPrediction(0),
+	fImageSectors(0),
+	fImageOutdated(false),
 	fNoteID(""),
 	fID(0),
 	fProgress(0),
 	fETAtime("--"),
 	fParser(fProgress, fETAtime),
 	fAbort(0),
-	fAction(IDLE)
+	fAction(IDLE),
+	fFitChecked(false)
 {
 	fWindowParent = &parent;
 
@@ -62,9 +81,7 @@ CompilationDVDView::CompilationDVDView(BurnWindow& parent)
 	fDiscLabel->TextView()->SetMaxBytes(32);
 	fDiscLabel->SetExplicitMaxSize(BSize(B_SIZE_UNLIMITED, B_SIZE_UNSET));
 
-	fOutputView = new BTextView("OutputView");
-	fOutputView->SetWordWrap(false);
-	fOutputView->MakeEditable(false);
+	fOutputView = new LogView("OutputView");
 	BScrollView* fOutputScrollView = new BScrollView("OutputScroller",
 		fOutputView, B_WILL_DRAW, true, true);
 	fOutputScrollView->SetExplicitMinSize(BSize(B_SIZE_UNSET, 64));
@@ -110,6 +127,17 @@ CompilationDVDView::CompilationDVDView(BurnWindow& parent)
 CompilationDVDView::~CompilationDVDView()
 {
 	delete fBurnerThread;
+	if (fPipeline != NULL)
+		fPipeline->PostMessage(B_QUIT_REQUESTED);
+	if (fFitPipeline != NULL)
+		fFitPipeline->PostMessage(B_QUIT_REQUESTED);
+	if (fSizePipeline != NULL)
+		fSizePipeline->PostMessage(B_QUIT_REQUESTED);
+	if (fSizeIndex != NULL) {
+		fSizeIndex->Stop();
+		fSizeIndex->PostMessage(B_QUIT_REQUESTED);
+	}
+	delete fMultiBurner;
 	delete fOpenPanel;
 }
 
@@ -152,15 +180,58 @@ CompilationDVDView::MessageReceived(BMessage* message)
 		case kBurnOutput:
 			_BurnOutput(message);
 			break;
+		case kOnTheFly:
+			// Nothing has to be built first to burn on-the-fly, otherwise
+			// only a built image can be burned
+			if (fAction == IDLE && fDirPath->InitCheck() == B_OK) {
+				fBurnButton->SetEnabled(
+					fWindowParent->GetSessionConfig().onthefly
+						|| !fBuildButton->IsEnabled());
+			}
+			break;
 		case B_REFS_RECEIVED:
 			_OpenDirectory(message);
 			break;
 		case kSetFolderSize:
 		{
+			// Left over from a folder chosen before?
+			if (message->GetInt32("generation", 0) != fSizeGeneration)
+				break;
+
+			int64 oldSize = fFolderSize;
 			message->FindInt64("foldersize", &fFolderSize);
+			fCountingSize = message->GetBool("partial", false);
+			fSizeWatched = message->GetBool("watched", true);
+			if (fCountingSize) {
+				_UpdateSizeBar();
+				fSizeView->ShowInfoText(B_TRANSLATE_COMMENT(
+					"calculating" B_UTF8_ELLIPSIS,
+					"In size view, as short as possible!"),
+					message->GetInt64("files", 0));
+				break;
+			}
+
+			// The image is laid out once the folder was counted. Changes
+			// after that only move the estimate, the next build lays it
+			// out again.
+			if (fPredictAfterCount) {
+				fPredictAfterCount = false;
+				_PredictImageSize();
+			} else {
+				if (fImageSectors > 0)
+					fImageSectors += (fFolderSize - oldSize) / 2;
+				fImageOutdated = true;
+			}
 			_UpdateSizeBar();
+			_ResumeBuild();
 			break;
 		}
+		case kImageSize:
+			_ImageSizeOutput(message);
+			break;
+		case kFitChecked:
+			_FitChecked(message);
+			break;
 
 		default:
 			BView::MessageReceived(message);
@@ -229,14 +300,34 @@ CompilationDVDView::_Build()
 
 	fAction = BUILDING;	// flag we're building ISO
 
-	// still getting folder size?
-	if (fFolderSize == 0) {
-		BMessage message(kBuildButton);
-		fRunner	= new BMessageRunner(this, &message, 1000000, 1); // 1 Hz
+	// Still counting the folder's size, or the image's, or did the folder
+	// change since the image was laid out? The build goes on once it's
+	// done. A folder with too many files to watch them all is counted
+	// again.
+	if (fCountingSize || fPredicting || fImageOutdated
+		|| (!fSizeWatched && !fSizeRecounted)) {
+		fBuildWaiting = true;
+		if (!fSizeWatched && !fSizeRecounted) {
+			if (!fCountingSize)
+				_GetFolderSize();
+		} else if (!fCountingSize && !fPredicting) {
+			_PredictImageSize();
+			_ResumeBuild();
+		}
 		return;
 	}
+	fSizeRecounted = false;
 
-	if (!CheckFreeSpace(fFolderSize * 1024, fImagePath->Path())) {
+	// What wouldn't fit on the disc in the drive isn't built
+	if (!fFitChecked && fImageSectors > 0) {
+		_CheckFit(kBuildButton, fImageSectors);
+		return;
+	}
+	fFitChecked = false;
+
+	int64 imageSize = fImageSectors > 0
+		? fImageSectors * 2048 : fFolderSize * 1024;
+	if (!CheckFreeSpace(imageSize, fImagePath->Path())) {
 		fAction = IDLE;
 		return;
 	}
@@ -252,22 +343,19 @@ CompilationDVDView::_Build()
 
 	fBurnerThread = new CommandThread(NULL,
 		new BInvoker(new BMessage(kBuildOutput), this));
+	fBurnerThread->SetSeparateStreams(true);
+	fBurnerThread->SetTimeout(kMkisofsTimeout);
 
-	BString discLabel;
-	if (fDiscLabel->TextView()->TextLength() == 0)
-		discLabel = fDirPath->Leaf();
-	else
-		discLabel = fDiscLabel->Text();
-
-	discLabel.Truncate(32, false);	//mkisofs limits to 32char labels
+	BStringList options;
+	_ImageOptions(options);
 
 	status_t ret = fImagePath->Append(kCacheFileDVD);
 	if (ret == B_OK) {
-		fBurnerThread->AddArgument("mkisofs")
-			->AddArgument("-V")
-			->AddArgument(discLabel)
-			->AddArgument(fDVDMode)
-			->AddArgument("-o")
+		fBurnerThread->AddArgument("mkisofs");
+		for (int32 i = 0; i < options.CountStrings(); i++)
+			fBurnerThread->AddArgument(options.StringAt(i));
+
+		fBurnerThread->AddArgument("-o")
 			->AddArgument(fImagePath->Path())
 			->AddArgument(fDirPath->Path())
 			->Run();
@@ -280,31 +368,31 @@ CompilationDVDView::_BuildOutput(BMessage* message)
 {
 	BString data;
 
-	if (message->FindString("line", &data) == B_OK) {
-		BString text = fOutputView->Text();
-		int32 modified = fParser.ParseMkisofsLine(text, data);
-		if (modified == NOCHANGE) {
-			data << "\n";
-			fOutputView->Insert(data.String());
-			fOutputView->ScrollBy(0.0, 50.0);
-		} else {
-			if (modified == PERCENT)
-				_UpdateProgress(B_TRANSLATE_COMMENT("Building DVD image",
-				"Notification title"));
-			fOutputView->SetText(text);
-			fOutputView->ScrollTo(0.0, 1000000.0);
-		}
+	for (int32 i = 0; message->FindString("line", i, &data) == B_OK; i++) {
+		int32 stream = -1;
+		message->FindInt32("stream", i, &stream);
+
+		ParseEvent event = fParser.ParseMkisofsLine(data, stream);
+		if (event.result == PERCENT)
+			_UpdateProgress(B_TRANSLATE_COMMENT("Building DVD image",
+			"Notification title"));
+		fOutputView->AddLine(data, event.replaceLine);
 	}
+	if (StopStalled(message, fBurnerThread, fOutputView))
+		fAbort = STALLED;
+
 	int32 code = -1;
 	if (message->FindInt32("thread_exit", &code) == B_OK) {
-		BString infoText(fOutputView->Text());
-		// mkisofs has same errors for dvd-video and dvd-hybrid, but
-		// no error checking for dvd-audio, apparently
-		if (infoText.FindFirst(
-			"mkisofs: Unable to make a DVD-Video image.\n") != B_ERROR) {
-			fInfoView->SetLabel(B_TRANSLATE_COMMENT(
-				"Unable to create a DVD image",
-				"Status notification"));
+		fProgressController.Flush();
+
+		// mkisofs exits with an error if it can't make a DVD-Video image
+		if (code != 0) {
+			fInfoView->SetLabel(fAbort == STALLED
+				? B_TRANSLATE_COMMENT(
+					"Building aborted: mkisofs stopped responding",
+					"Status notification")
+				: B_TRANSLATE_COMMENT("Unable to create a DVD image",
+					"Status notification"));
 			fBurnButton->SetEnabled(false);
 
 			BNotification buildAbort(B_IMPORTANT_NOTIFICATION);
@@ -340,6 +428,7 @@ CompilationDVDView::_BuildOutput(BMessage* message)
 			}
 		}
 		fAction = IDLE;
+		fAbort = 0;
 	}
 }
 
@@ -347,28 +436,55 @@ CompilationDVDView::_BuildOutput(BMessage* message)
 void
 CompilationDVDView::_Burn()
 {
-	BFile testFile(fImagePath->Path(), B_READ_ONLY);
-	status_t result = testFile.InitCheck();
-
-	if (result != B_OK) {
-		BString text(B_TRANSLATE_COMMENT(
-			"There isn't an image '%filename%' in the cache folder. "
-			"Was it perhaps moved or renamed?", "Alert text"));
-		text.ReplaceFirst("%filename%", kCacheFileDVD);
-		(new BAlert("ImageNotFound", text,
-			B_TRANSLATE("OK")))->Go();
+	sessionConfig config = fWindowParent->GetSessionConfig();
 
+	if (config.onthefly) {
+		BEntry folder(fDirPath->Path());
+		if (fDirPath->InitCheck() != B_OK || !folder.Exists()) {
+			BString text(B_TRANSLATE_COMMENT(
+				"The chosen folder '%foldername%' seems to have disappeared. "
+				"Was it perhaps moved or renamed?", "Alert text"));
+			text.ReplaceFirst("%foldername%", fDirPath->Path());
+			(new BAlert("FolderNotFound", text,
+				B_TRANSLATE("OK")))->Go();
+			return;
+		}
+	} else {
+		BFile testFile(fImagePath->Path(), B_READ_ONLY);
+		status_t result = testFile.InitCheck();
+
+		if (result != B_OK) {
+			BString text(B_TRANSLATE_COMMENT(
+				"There isn't an image '%filename%' in the cache folder. "
+				"Was it perhaps moved or renamed?", "Alert text"));
+			text.ReplaceFirst("%filename%", kCacheFileDVD);
+			(new BAlert("ImageNotFound", text,
+				B_TRANSLATE("OK")))->Go();
+
+			testFile.Unset();
+			return;
+		}
 		testFile.Unset();
+	}
+
+	// A built image is checked against the disc before it's burned,
+	// on-the-fly that's a stage of the pipeline
+	if (!config.onthefly && !fFitChecked) {
+		off_t imageSize = 0;
+		BEntry(fImagePath->Path()).GetSize(&imageSize);
+		_CheckFit(kBurnButton, (imageSize + 2047) / 2048);
 		return;
 	}
-	testFile.Unset();
+	fFitChecked = false;
 
 	if (fBurnerThread != NULL)
 		delete fBurnerThread;
+	fBurnerThread = NULL;
+	delete fMultiBurner;
+	fMultiBurner = NULL;
 
 	fAction = BURNING;	// flag we're burning
-
-	fOutputView->SetText(NULL);
+	fOutputView->Clear();
 	fInfoView->SetLabel(B_TRANSLATE_COMMENT(
 		"Burning in progress" B_UTF8_ELLIPSIS,"Status notification"));
 	fDVDButton->SetEnabled(false);
@@ -391,30 +507,73 @@ CompilationDVDView::_Burn()
 
 	BString device("dev=");
 	device.Append(fWindowParent->GetSelectedDevice().number.String());
-	sessionConfig config = fWindowParent->GetSessionConfig();
 
-	fBurnerThread = new CommandThread(NULL,
-		new BInvoker(new BMessage(kBurnOutput), this));
-	fBurnerThread->AddArgument("cdrecord");
+	sdevice drives[MAX_DEVICES];
+	int32 driveCount = fWindowParent->GetBurnDevices(drives);
+
+	BStringList arguments;
+	arguments.Add("cdrecord");
 
 	if (config.simulation)
-		fBurnerThread->AddArgument("-dummy");
+		arguments.Add("-dummy");
 	if (config.eject)
-		fBurnerThread->AddArgument("-eject");
+		arguments.Add("-eject");
 	if (config.speed != "")
-		fBurnerThread->AddArgument(config.speed);
-
-	fBurnerThread->AddArgument(config.mode)
-		->AddArgument("fs=16m")
-		->AddArgument(device)
-		->AddArgument("-v")	// to get progress output
-		->AddArgument("gracetime=2")
-		->AddArgument("-pad")
-		->AddArgument("padsize=63s")
-		->AddArgument(fImagePath->Path())
-		->Run();
+		arguments.Add(config.speed);
+
+	arguments.Add(config.mode);
+	arguments.Add("fs=16m");
+	arguments.Add("-v");	// to get progress output
+	arguments.Add("gracetime=2");
+	arguments.Add("-pad");
+	arguments.Add("padsize=63s");
 
 	fParser.Reset();
+
+	if (config.onthefly) {
+		// mkisofs writes the image straight into cdrecord, which needs to
+		// know its size before, though. Only the selected drive is used.
+		arguments.Add(device);
+
+		BStringList options;
+		_ImageOptions(options);
+
+		if (fPipeline != NULL)
+			fPipeline->PostMessage(B_QUIT_REQUESTED);
+
+		fPipeline = new JobPipeline(new BInvoker(new BMessage(kBurnOutput),
+			this));
+		fPipeline->AddStage(new ImageSizeStage(options, fDirPath->Path()));
+		fPipeline->AddStage(new MediaFitStage(device));
+		fPipeline->AddStage(new OnTheFlyBurnStage(options, fDirPath->Path(),
+			arguments));
+		fPipeline->Start();
+		return;
+	}
+
+	if (driveCount > 1) {
+		fMultiBurner = new MultiBurner(this, kBurnOutput);
+		for (int32 i = 0; i < driveCount; i++)
+			fMultiBurner->AddDrive(drives[i], arguments, fImagePath->Path());
+		if (fMultiBurner->Run() != B_OK) {
+			// No cdrecord is running that could report its exit
+			_BurnFinished(fMultiBurner->CountFailed(), false);
+			fInfoView->SetLabel(fMultiBurner->Status());
+		}
+		return;
+	}
+
+	fBurnerThread = new CommandThread(NULL,
+		new BInvoker(new BMessage(kBurnOutput), this));
+	fBurnerThread->SetSeparateStreams(true);
+	fBurnerThread->SetTimeout(kCdrecordTimeout);
+
+	for (int32 i = 0; i < arguments.CountStrings(); i++)
+		fBurnerThread->AddArgument(arguments.StringAt(i));
+
+	fBurnerThread->AddArgument(device)
+		->AddArgument(fImagePath->Path())
+		->Run();
 }
 
 
@@ -423,61 +582,159 @@ CompilationDVDView::_BurnOutput(BMessage* message)
 {
 	BString data;
 
-	if (message->FindString("line", &data) == B_OK) {
-		BString text = fOutputView->Text();
-		int32 modified = fParser.ParseCdrecordLine(text, data);
-		if (modified < 0)
-			fAbort = modified;
-		if (modified <= 0) {
-			data << "\n";
-			fOutputView->Insert(data.String());
-			fOutputView->ScrollBy(0.0, 50.0);
-		} else {
-			if (modified == PERCENT)
-				_UpdateProgress(B_TRANSLATE_COMMENT("Burning DVD",
-				"Notification title"));
-			fOutputView->SetText(text);
-			fOutputView->ScrollTo(0.0, 1000000.0);
-		}
+	if (fMultiBurner != NULL && message->HasInt32("drive")) {
+		_MultiBurnOutput(message);
+		return;
+	}
+
+	// When burning on-the-fly, the output comes from a JobPipeline
+	int32 stage = kOnTheFlyBurnStage;
+	if (message->HasInt32("stage_start") || message->HasInt32("stage_done"))
+		return;
+	bool piped = message->FindInt32("stage", &stage) == B_OK;
+
+	// A JobPipeline stops its commands itself, and ends with B_TIMED_OUT
+	if (StopStalled(message, piped ? NULL : fBurnerThread, fOutputView)
+		&& !piped)
+		fAbort = STALLED;
+
+	int32 fill;
+	if (message->FindInt32("fifo_fill", &fill) == B_OK) {
+		BString label(B_TRANSLATE_COMMENT(
+			"Burning in progress" B_UTF8_ELLIPSIS " (fifo %fill%%)",
+			"Status notification"));
+		BString percent;
+		percent << fill;
+		label.ReplaceFirst("%fill%", percent);
+		fInfoView->SetLabel(label);
+	}
+
+	for (int32 i = 0; message->FindString("line", i, &data) == B_OK; i++) {
+		int32 stream = -1;
+		message->FindInt32("stream", i, &stream);
+
+		ParseEvent event;
+		if (stage == kOnTheFlyBurnStage)
+			event = fParser.ParseCdrecordLine(data, stream);
+		if (event.result < 0)
+			fAbort = event.result;
+		else if (event.result == PERCENT)
+			_UpdateProgress(B_TRANSLATE_COMMENT("Burning DVD",
+			"Notification title"));
+		fOutputView->AddLine(data, event.replaceLine);
+		ShowBufferFill(event, fParser.Buffers(), fSizeView, fOutputView);
 	}
 	int32 code = -1;
-	if (message->FindInt32("thread_exit", &code) == B_OK) {
-		if (fAbort == SMALLDISC) {
-			fInfoView->SetLabel(B_TRANSLATE_COMMENT(
-				"Burning aborted: The data doesn't fit on the disc",
-				"Status notification"));
+	bool onTheFly = message->FindInt32("pipeline_exit", &code) == B_OK;
+	if (onTheFly && code == B_DEVICE_FULL) {
+		// Found out before anything was burned
+		BMessage results;
+		message->FindMessage("results", &results);
+		DiscTooSmallAlert(results);
+		fAbort = SMALLDISC;
+	} else if (onTheFly && code == B_TIMED_OUT)
+		fAbort = STALLED;
+	if (onTheFly || message->FindInt32("thread_exit", &code) == B_OK)
+		_BurnFinished(code, onTheFly);
+}
 
-			BNotification burnAbort(B_IMPORTANT_NOTIFICATION);
-			burnAbort.SetGroup("BurnItNow");
-			burnAbort.SetTitle(B_TRANSLATE_COMMENT("Burning aborted",
-				"Notification title"));
-			burnAbort.SetContent(B_TRANSLATE_COMMENT(
-				"The data doesn't fit on the disc.", "Notification content"));
-			burnAbort.SetMessageID(fNoteID);
-			burnAbort.Send();
-		} else {
-			fInfoView->SetLabel(B_TRANSLATE_COMMENT(
-				"Burning complete. Burn another disc?",
-				"Status notification"));
 
-			BNotification burnSuccess(B_INFORMATION_NOTIFICATION);
-			burnSuccess.SetGroup("BurnItNow");
-			burnSuccess.SetTitle(B_TRANSLATE_COMMENT("Burning DVD",
-				"Notification title"));
-			burnSuccess.SetContent(B_TRANSLATE_COMMENT("Burning finished!",
-				"Notification content"));
-			burnSuccess.SetMessageID(fNoteID);
-			burnSuccess.Send();
-		}
+void
+CompilationDVDView::_BurnFinished(int32 code, bool onTheFly)
+{
+	fProgressController.Flush();
+
+	if (fAbort == SMALLDISC) {
+		fInfoView->SetLabel(B_TRANSLATE_COMMENT(
+			"Burning aborted: The data doesn't fit on the disc",
+			"Status notification"));
+
+		BNotification burnAbort(B_IMPORTANT_NOTIFICATION);
+		burnAbort.SetGroup("BurnItNow");
+		burnAbort.SetTitle(B_TRANSLATE_COMMENT("Burning aborted",
+			"Notification title"));
+		burnAbort.SetContent(B_TRANSLATE_COMMENT(
+			"The data doesn't fit on the disc.", "Notification content"));
+		burnAbort.SetMessageID(fNoteID);
+		burnAbort.Send();
+	} else if (fAbort == STALLED) {
+		fInfoView->SetLabel(B_TRANSLATE_COMMENT(
+			"Burning aborted: The burner stopped responding",
+			"Status notification"));
+
+		BNotification burnAbort(B_IMPORTANT_NOTIFICATION);
+		burnAbort.SetGroup("BurnItNow");
+		burnAbort.SetTitle(B_TRANSLATE_COMMENT("Burning aborted",
+			"Notification title"));
+		burnAbort.SetContent(B_TRANSLATE_COMMENT(
+			"The burner stopped responding.", "Notification content"));
+		burnAbort.SetMessageID(fNoteID);
+		burnAbort.Send();
+	} else if (code != 0) {
+		fInfoView->SetLabel(B_TRANSLATE_COMMENT(
+			"Burning failed", "Status notification"));
+
+		BNotification burnAbort(B_IMPORTANT_NOTIFICATION);
+		burnAbort.SetGroup("BurnItNow");
+		burnAbort.SetTitle(B_TRANSLATE_COMMENT("Burning aborted",
+			"Notification title"));
+		burnAbort.SetContent(B_TRANSLATE_COMMENT(
+			"Burning the disc failed.", "Notification content"));
+		burnAbort.SetMessageID(fNoteID);
+		burnAbort.Send();
+	} else {
+		fInfoView->SetLabel(B_TRANSLATE_COMMENT(
+			"Burning complete. Burn another disc?",
+			"Status notification"));
+
+		BNotification burnSuccess(B_INFORMATION_NOTIFICATION);
+		burnSuccess.SetGroup("BurnItNow");
+		burnSuccess.SetTitle(B_TRANSLATE_COMMENT("Burning DVD",
+			"Notification title"));
+		burnSuccess.SetContent(B_TRANSLATE_COMMENT("Burning finished!",
+			"Notification content"));
+		burnSuccess.SetMessageID(fNoteID);
+		burnSuccess.Send();
+	}
 
-		fDVDButton->SetEnabled(true);
-		fBuildButton->SetEnabled(false);
-		fBurnButton->SetEnabled(true);
+	fDVDButton->SetEnabled(true);
+	// Without an image, it can still be built after burning on-the-fly
+	fBuildButton->SetEnabled(onTheFly);
+	fBurnButton->SetEnabled(true);
+
+	fAction = IDLE;
+	fAbort = 0;
+	fSizeView->HideBufferFill();
+	BString summary = BufferSummary(fParser.Buffers());
+	if (!summary.IsEmpty())
+		fOutputView->AddLine(summary);
+	fParser.Reset();
+}
 
-		fAction = IDLE;
-		fAbort = 0;
-		fParser.Reset();
+
+void
+CompilationDVDView::_CheckFit(int32 action, int64 sectors)
+{
+	// Each drive that burns is asked about its disc first, _FitChecked()
+	// goes on with "action"
+	if (fFitPipeline != NULL)
+		return;
+
+	sdevice drives[MAX_DEVICES];
+	int32 driveCount = fWindowParent->GetBurnDevices(drives);
+
+	BMessage* message = new BMessage(kFitChecked);
+	message->AddInt32("action", action);
+	fFitPipeline = new JobPipeline(new BInvoker(message, this));
+	for (int32 i = 0; i < driveCount; i++) {
+		BString device("dev=");
+		device.Append(drives[i].number.String());
+		fFitPipeline->AddStage(new MediaFitStage(device, sectors));
 	}
+	fFitPipeline->Start();
+
+	fInfoView->SetLabel(B_TRANSLATE_COMMENT(
+		"Checking the disc" B_UTF8_ELLIPSIS, "Status notification"));
 }
 
 
@@ -495,22 +752,135 @@ CompilationDVDView::_ChooseDirectory()
 
 
 void
-CompilationDVDView::_GetFolderSize()
+CompilationDVDView::_FitChecked(BMessage* message)
 {
-	BMessage* msg = new BMessage('NULL');
-	msg->AddString("path", fDirPath->Path());
-	msg->AddMessenger("from", this);
+	int32 status;
+	if (message->FindInt32("pipeline_exit", &status) != B_OK)
+		return;
+
+	fFitPipeline->PostMessage(B_QUIT_REQUESTED);
+	fFitPipeline = NULL;
+
+	int32 action = message->GetInt32("action", kBurnButton);
+	if (status == B_DEVICE_FULL) {
+		BMessage results;
+		message->FindMessage("results", &results);
+		DiscTooSmallAlert(results);
+
+		fInfoView->SetLabel(B_TRANSLATE_COMMENT(
+			"The data doesn't fit on the disc", "Status notification"));
+		if (action == kBuildButton) {
+			fAction = IDLE;
+
+			BNotification buildAbort(B_IMPORTANT_NOTIFICATION);
+			buildAbort.SetGroup("BurnItNow");
+			buildAbort.SetTitle(B_TRANSLATE_COMMENT("Building aborted",
+				"Notification title"));
+			buildAbort.SetContent(B_TRANSLATE_COMMENT(
+				"The data doesn't fit on the disc.", "Notification content"));
+			buildAbort.SetMessageID(fNoteID);
+			buildAbort.Send();
+		}
+		return;
+	}
 
-	thread_id sizecount = spawn_thread(FolderSizeCount,
-		"Folder size counter", B_LOW_PRIORITY, msg);
+	// Anything else is left to cdrecord
+	fFitChecked = true;
+	if (action == kBuildButton)
+		_Build();
+	else
+		_Burn();
+}
 
-	if (sizecount >= B_OK)
-		resume_thread(sizecount);
+
+void
+CompilationDVDView::_GetFolderSize()
+{
+	// The index keeps the size up to date from now on
+	if (fSizeIndex == NULL) {
+		fSizeIndex = new FolderSizeIndex(new BInvoker(
+			new BMessage(kSetFolderSize), this));
+		fSizeIndex->Run();
+	}
+	fSizeGeneration = fSizeIndex->SetFolder(fDirPath->Path());
+	fCountingSize = true;
+	fPredictAfterCount = true;
+	fImageSectors = 0;
+	fImageOutdated = false;
 
 	fSizeView->ShowInfoText(B_TRANSLATE_COMMENT("calculating" B_UTF8_ELLIPSIS,
 		"In size view, as short as possible!"));}
 
 
+void
+CompilationDVDView::_ImageOptions(BStringList& options)
+{
+	BString discLabel;
+	if (fDiscLabel->TextView()->TextLength() == 0)
+		discLabel = fDirPath->Leaf();
+	else
+		discLabel = fDiscLabel->Text();
+
+	discLabel.Truncate(32, false);	//mkisofs limits to 32char labels
+
+	options.Add("-V");
+	options.Add(discLabel);
+	options.Add(fDVDMode);
+}
+
+
+void
+CompilationDVDView::_ImageSizeOutput(BMessage* message)
+{
+	int32 status;
+	if (message->GetInt32("prediction", 0) != fPrediction
+		|| message->FindInt32("pipeline_exit", &status) != B_OK)
+		return;
+
+	fSizePipeline->PostMessage(B_QUIT_REQUESTED);
+	fSizePipeline = NULL;
+
+	BMessage results;
+	message->FindMessage("results", &results);
+	fPredicting = false;
+	fImageSectors = status == B_OK
+		? results.GetInt64("image_sectors", 0) : 0;
+	_UpdateSizeBar();
+	_ResumeBuild();
+}
+
+
+void
+CompilationDVDView::_MultiBurnOutput(BMessage* message)
+{
+	BString output;
+	bool done = fMultiBurner->ParseOutput(message, output);
+	if (!output.IsEmpty()) {
+		fOutputView->AddText(output.String());
+	}
+
+	if (!done) {
+		fInfoView->SetLabel(fMultiBurner->Status());
+		fProgress = fMultiBurner->Progress();
+		fETAtime = fMultiBurner->ETA();
+		if (message->HasString("line"))
+			_UpdateProgress(B_TRANSLATE_COMMENT("Burning DVD",
+				"Notification title"));
+		return;
+	}
+
+	if (fMultiBurner->DiscTooSmall())
+		fAbort = SMALLDISC;
+
+	int32 failed = fMultiBurner->CountFailed();
+	_BurnFinished(failed, false);
+
+	// Show which of the drives failed
+	if (failed > 0)
+		fInfoView->SetLabel(fMultiBurner->Status());
+}
+
+
 void
 CompilationDVDView::_OpenDirectory(BMessage* message)
 {
@@ -570,7 +940,7 @@ CompilationDVDView::_OpenDirectory(BMessage* message)
 	}
 
 	fFolderSize = 0;
-	fOutputView->SetText(NULL);
+	fOutputView->Clear();
 
 	fPathView->SetText(fDirPath->Path());
 
@@ -582,7 +952,7 @@ CompilationDVDView::_OpenDirectory(BMessage* message)
 	}
 
 	fBuildButton->SetEnabled(true);
-	fBurnButton->SetEnabled(false);
+	fBurnButton->SetEnabled(fWindowParent->GetSessionConfig().onthefly);
 	fInfoView->SetLabel(B_TRANSLATE_COMMENT("Build the DVD image",
 		"Status notification"));
 
@@ -590,22 +960,55 @@ CompilationDVDView::_OpenDirectory(BMessage* message)
 }
 
 
+void
+CompilationDVDView::_PredictImageSize()
+{
+	// mkisofs tells the size of the image it builds with the options of
+	// _Build()
+	if (fSizePipeline != NULL)
+		fSizePipeline->PostMessage(B_QUIT_REQUESTED);
+	fImageOutdated = false;
+
+	BMessage* message = new BMessage(kImageSize);
+	message->AddInt32("prediction", ++fPrediction);
+	fSizePipeline = new JobPipeline(new BInvoker(message, this));
+
+	BStringList options;
+	_ImageOptions(options);
+	fSizePipeline->AddStage(new ImageSizeStage(options, fDirPath->Path()));
+	fPredicting = fSizePipeline->Start() == B_OK;
+}
+
+
+void
+CompilationDVDView::_ResumeBuild()
+{
+	// A build that waited for the size goes on
+	if (!fBuildWaiting || fCountingSize || fPredicting)
+		return;
+
+	fBuildWaiting = false;
+	fSizeRecounted = true;
+	_Build();
+}
+
+
 
 void
 CompilationDVDView::_UpdateProgress(const char* title)
 {
-	BNotification burnProgress(B_PROGRESS_NOTIFICATION);
-	burnProgress.SetGroup("BurnItNow");
-	burnProgress.SetTitle(title);
-	burnProgress.SetContent(fETAtime);
-	burnProgress.SetProgress(fProgress);
-	burnProgress.SetMessageID(fNoteID);
-	burnProgress.Send();
+	fProgressController.Update(fNoteID, title, fETAtime, fProgress);
 }
 
 
 void
 CompilationDVDView::_UpdateSizeBar()
 {
-	fSizeView->UpdateSizeDisplay(fFolderSize, DATA, DVD_ONLY); // size in KiB
+	// Once it's known, the size of the image as it's burned, with the
+	// padding, otherwise that of the files
+	int64 size = fFolderSize;
+	if (fImageSectors > 0)
+		size = (fImageSectors + kPadSectors) * 2;
+
+	fSizeView->UpdateSizeDisplay(size, DATA, DVD_ONLY); // size in KiB
 }
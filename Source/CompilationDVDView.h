@@ -8,19 +8,22 @@
 #include <Button.h>
 #include <FilePanel.h>
 #include <Menu.h>
-#include <MessageRunner.h>
 #include <SeparatorView.h>
 #include <TextControl.h>
-#include <TextView.h>
 #include <View.h>
 
 #include "BurnWindow.h"
 #include "CompilationShared.h"
+#include "LogView.h"
 #include "OutputParser.h"
+#include "ProgressController.h"
 #include "SizeView.h"
 
 
 class CommandThread;
+class FolderSizeIndex;
+class JobPipeline;
+class MultiBurner;
 
 
 class CompilationDVDView : public BView {
@@ -37,16 +40,27 @@ private:
 	void			_Build();
 	void 			_BuildOutput(BMessage* message);
 	void			_Burn();
+	void			_BurnFinished(int32 code, bool onTheFly);
 	void 			_BurnOutput(BMessage* message);
+	void			_CheckFit(int32 action, int64 sectors);
 	void 			_ChooseDirectory();
+	void			_FitChecked(BMessage* message);
 	void			_GetFolderSize();
+	void			_ImageOptions(BStringList& options);
+	void			_ImageSizeOutput(BMessage* message);
+	void			_MultiBurnOutput(BMessage* message);
 	void 			_OpenDirectory(BMessage* message);
+	void			_PredictImageSize();
+	void			_ResumeBuild();
 	void			_UpdateProgress(const char* title);
 	void			_UpdateSizeBar();
 
 	CommandThread* 	fBurnerThread;
+	JobPipeline*	fPipeline;
+	JobPipeline*	fFitPipeline;
+	MultiBurner*	fMultiBurner;
 	BurnWindow* 	fWindowParent;
-	BTextView* 		fOutputView;
+	LogView* 		fOutputView;
 	BFilePanel* 	fOpenPanel;
 	BSeparatorView*	fInfoView;
 	PathView*		fPathView;
@@ -60,17 +74,32 @@ private:
 	const char*		fDVDMode;
 
 	int64			fFolderSize;
+	bool			fCountingSize;
+	bool			fSizeWatched;
+	bool			fSizeRecounted;
+	bool			fBuildWaiting;
+	FolderSizeIndex* fSizeIndex;
+	JobPipeline*	fSizePipeline;
+	int32			fSizeGeneration;
+	bool			fPredicting;
+	bool			fPredictAfterCount;
+	int32			fPrediction;
+	// Of the image the build would write, 0 while unknown. After the
+	// folder changed, it's only estimated until the next build.
+	int64			fImageSectors;
+	bool			fImageOutdated;
 	SizeView*		fSizeView;
 
 	BString			fNoteID;
 	int32			fID;
 	float			fProgress;
 	BString			fETAtime;
+	ProgressController fProgressController;
 	OutputParser	fParser;
 
 	int32			fAbort;
 	int32			fAction;
-	BMessageRunner*	fRunner;
+	bool			fFitChecked;
 };
 
 
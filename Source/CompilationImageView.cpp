@@ -8,6 +8,7 @@
 #include <Alert.h>
 #include <ControlLook.h>
 #include <Catalog.h>
+#include <Entry.h>
 #include <LayoutBuilder.h>
 #include <Node.h>
 #include <NodeInfo.h>
@@ -21,6 +22,8 @@
 #include "CommandThread.h"
 #include "CompilationImageView.h"
 #include "Constants.h"
+#include "JobPipeline.h"
+#include "MultiBurner.h"
 
 
 #undef B_TRANSLATION_CONTEXT
@@ -32,6 +35,8 @@ CompilationImageView::CompilationImageView(BurnWindow& parent)
 	BView(B_TRANSLATE_COMMENT("Image file", "Tab label"), B_WILL_DRAW,
 		new BGroupLayout(B_VERTICAL, kControlPadding)),
 	fBurnerThread(NULL),
+	fMultiBurner(NULL),
+	fFitPipeline(NULL),
 	fOpenPanel(NULL),
 	fImagePath(new BPath()),
 	fNoteID(""),
@@ -40,7 +45,8 @@ CompilationImageView::CompilationImageView(BurnWindow& parent)
 	fETAtime("--"),
 	fParser(fProgress, fETAtime),
 	fAbort(0),
-	fAction(IDLE)
+	fAction(IDLE),
+	fFitChecked(false)
 {
 	fWindowParent = &parent;
 
@@ -54,9 +60,7 @@ CompilationImageView::CompilationImageView(BurnWindow& parent)
 	fPathView = new PathView("ImageFileStringView",
 		B_TRANSLATE("Image: <none>"));
 
-	fOutputView = new BTextView("OutputView");
-	fOutputView->SetWordWrap(false);
-	fOutputView->MakeEditable(false);
+	fOutputView = new LogView("OutputView");
 	BScrollView* fOutputScrollView = new BScrollView("OutputScroller",
 		fOutputView, B_WILL_DRAW, true, true);
 	fOutputScrollView->SetExplicitMinSize(BSize(B_SIZE_UNSET, 64));
@@ -97,6 +101,9 @@ CompilationImageView::~CompilationImageView()
 {
 	delete fImagePath;
 	delete fBurnerThread;
+	delete fMultiBurner;
+	if (fFitPipeline != NULL)
+		fFitPipeline->PostMessage(B_QUIT_REQUESTED);
 	delete fOpenPanel;
 }
 
@@ -133,6 +140,9 @@ CompilationImageView::MessageReceived(BMessage* message)
 		case kBurnOutput:
 			_BurnOutput(message);
 			break;
+		case kFitChecked:
+			_FitChecked(message);
+			break;
 		case B_REFS_RECEIVED:
 			_OpenImage(message);
 			break;
@@ -209,14 +219,26 @@ CompilationImageView::_Burn()
 	}
 	testFile.Unset();
 
+	// The image is checked against the disc before it's burned
+	if (!fFitChecked) {
+		off_t imageSize = 0;
+		BEntry(fImagePath->Path()).GetSize(&imageSize);
+		_CheckFit(kBurnButton, (imageSize + 2047) / 2048);
+		return;
+	}
+	fFitChecked = false;
+
 	if (fBurnerThread != NULL)
 		delete fBurnerThread;
+	fBurnerThread = NULL;
+	delete fMultiBurner;
+	fMultiBurner = NULL;
 
 	fAction = BURNING;	// flag we're burning
 	fChooseButton->SetEnabled(false);
 	fBurnButton->SetEnabled(false);
 
-	fOutputView->SetText(NULL);
+	fOutputView->Clear();
 	fInfoView->SetLabel(B_TRANSLATE_COMMENT(
 		"Burning in progress" B_UTF8_ELLIPSIS, "Status notification"));
 
@@ -238,29 +260,51 @@ CompilationImageView::_Burn()
 	device.Append(fWindowParent->GetSelectedDevice().number.String());
 	sessionConfig config = fWindowParent->GetSessionConfig();
 
-	fBurnerThread = new CommandThread(NULL,
-		new BInvoker(new BMessage(kBurnOutput), this));
+	sdevice drives[MAX_DEVICES];
+	int32 driveCount = fWindowParent->GetBurnDevices(drives);
 
-	fBurnerThread->AddArgument("cdrecord");
+	BStringList arguments;
+	arguments.Add("cdrecord");
 
 	if (config.simulation)
-		fBurnerThread->AddArgument("-dummy");
+		arguments.Add("-dummy");
 	if (config.eject)
-		fBurnerThread->AddArgument("-eject");
+		arguments.Add("-eject");
 	if (config.speed != "")
-		fBurnerThread->AddArgument(config.speed);
-
-	fBurnerThread->AddArgument(config.mode)
-		->AddArgument("fs=16m")
-		->AddArgument(device)
-		->AddArgument("-v")	// to get progress output
-		->AddArgument("gracetime=2")
-		->AddArgument("-pad")
-		->AddArgument("padsize=63s")
-		->AddArgument(fImagePath->Path())
-		->Run();
+		arguments.Add(config.speed);
+
+	arguments.Add(config.mode);
+	arguments.Add("fs=16m");
+	arguments.Add("-v");	// to get progress output
+	arguments.Add("gracetime=2");
+	arguments.Add("-pad");
+	arguments.Add("padsize=63s");
 
 	fParser.Reset();
+
+	if (driveCount > 1) {
+		fMultiBurner = new MultiBurner(this, kBurnOutput);
+		for (int32 i = 0; i < driveCount; i++)
+			fMultiBurner->AddDrive(drives[i], arguments, fImagePath->Path());
+		if (fMultiBurner->Run() != B_OK) {
+			// No cdrecord is running that could report its exit
+			_BurnFinished(fMultiBurner->CountFailed());
+			fInfoView->SetLabel(fMultiBurner->Status());
+		}
+		return;
+	}
+
+	fBurnerThread = new CommandThread(NULL,
+		new BInvoker(new BMessage(kBurnOutput), this));
+	fBurnerThread->SetSeparateStreams(true);
+	fBurnerThread->SetTimeout(kCdrecordTimeout);
+
+	for (int32 i = 0; i < arguments.CountStrings(); i++)
+		fBurnerThread->AddArgument(arguments.StringAt(i));
+
+	fBurnerThread->AddArgument(device)
+		->AddArgument(fImagePath->Path())
+		->Run();
 }
 
 
@@ -269,60 +313,127 @@ CompilationImageView::_BurnOutput(BMessage* message)
 {
 	BString data;
 
-	if (message->FindString("line", &data) == B_OK) {
-		BString text = fOutputView->Text();
-		int32 modified = fParser.ParseCdrecordLine(text, data);
-		if (modified < 0)
-			fAbort = modified;
-		if (modified <= 0) {
-			data << "\n";
-			fOutputView->Insert(data.String());
-			fOutputView->ScrollBy(0.0, 50.0);
-		} else {
-			if (modified == PERCENT)
-				_UpdateProgress(B_TRANSLATE_COMMENT("Burning image",
-				"Notification title"));
-			fOutputView->SetText(text);
-			fOutputView->ScrollTo(0.0, 1000000.0);
-		}
+	if (fMultiBurner != NULL && message->HasInt32("drive")) {
+		_MultiBurnOutput(message);
+		return;
 	}
+
+	for (int32 i = 0; message->FindString("line", i, &data) == B_OK; i++) {
+		int32 stream = -1;
+		message->FindInt32("stream", i, &stream);
+
+		ParseEvent event = fParser.ParseCdrecordLine(data, stream);
+		if (event.result < 0)
+			fAbort = event.result;
+		else if (event.result == PERCENT)
+			_UpdateProgress(B_TRANSLATE_COMMENT("Burning image",
+			"Notification title"));
+		fOutputView->AddLine(data, event.replaceLine);
+		ShowBufferFill(event, fParser.Buffers(), fSizeView, fOutputView);
+	}
+	if (StopStalled(message, fBurnerThread, fOutputView))
+		fAbort = STALLED;
+
 	int32 code = -1;
-	if (message->FindInt32("thread_exit", &code) == B_OK) {
-		if (fAbort == SMALLDISC) {
-			fInfoView->SetLabel(B_TRANSLATE_COMMENT(
-				"Burning aborted: The data doesn't fit on the disc",
-				"Status notification"));
-
-			BNotification burnAbort(B_IMPORTANT_NOTIFICATION);
-			burnAbort.SetGroup("BurnItNow");
-			burnAbort.SetTitle(B_TRANSLATE_COMMENT("Burning aborted",
-				"Notification title"));
-			burnAbort.SetContent(B_TRANSLATE_COMMENT(
-				"The data doesn't fit on the disc.", "Notification content"));
-			burnAbort.SetMessageID(fNoteID);
-			burnAbort.Send();
-		} else {
-			fInfoView->SetLabel(B_TRANSLATE_COMMENT(
-				"Burning complete. Burn another disc?",
-				"Status notification"));
-
-			BNotification burnSuccess(B_INFORMATION_NOTIFICATION);
-			burnSuccess.SetGroup("BurnItNow");
-			burnSuccess.SetTitle(B_TRANSLATE_COMMENT("Burning image",
-				"Notification title"));
-			burnSuccess.SetContent(B_TRANSLATE_COMMENT("Burning finished!",
-				"Notification content"));
-			burnSuccess.SetMessageID(fNoteID);
-			burnSuccess.Send();
-		}
+	if (message->FindInt32("thread_exit", &code) == B_OK)
+		_BurnFinished(code);
+}
 
-		fChooseButton->SetEnabled(true);
-		fBurnButton->SetEnabled(true);
 
-		fAction = IDLE;
-		fAbort = 0;
-		fParser.Reset();
+void
+CompilationImageView::_BurnFinished(int32 code)
+{
+	fProgressController.Flush();
+
+	if (fAbort == SMALLDISC) {
+		fInfoView->SetLabel(B_TRANSLATE_COMMENT(
+			"Burning aborted: The data doesn't fit on the disc",
+			"Status notification"));
+
+		BNotification burnAbort(B_IMPORTANT_NOTIFICATION);
+		burnAbort.SetGroup("BurnItNow");
+		burnAbort.SetTitle(B_TRANSLATE_COMMENT("Burning aborted",
+			"Notification title"));
+		burnAbort.SetContent(B_TRANSLATE_COMMENT(
+			"The data doesn't fit on the disc.", "Notification content"));
+		burnAbort.SetMessageID(fNoteID);
+		burnAbort.Send();
+	} else if (fAbort == STALLED) {
+		fInfoView->SetLabel(B_TRANSLATE_COMMENT(
+			"Burning aborted: The burner stopped responding",
+			"Status notification"));
+
+		BNotification burnAbort(B_IMPORTANT_NOTIFICATION);
+		burnAbort.SetGroup("BurnItNow");
+		burnAbort.SetTitle(B_TRANSLATE_COMMENT("Burning aborted",
+			"Notification title"));
+		burnAbort.SetContent(B_TRANSLATE_COMMENT(
+			"The burner stopped responding.", "Notification content"));
+		burnAbort.SetMessageID(fNoteID);
+		burnAbort.Send();
+	} else if (code != 0) {
+		fInfoView->SetLabel(B_TRANSLATE_COMMENT(
+			"Burning failed", "Status notification"));
+
+		BNotification burnAbort(B_IMPORTANT_NOTIFICATION);
+		burnAbort.SetGroup("BurnItNow");
+		burnAbort.SetTitle(B_TRANSLATE_COMMENT("Burning aborted",
+			"Notification title"));
+		burnAbort.SetContent(B_TRANSLATE_COMMENT(
+			"Burning the disc failed.", "Notification content"));
+		burnAbort.SetMessageID(fNoteID);
+		burnAbort.Send();
+	} else {
+		fInfoView->SetLabel(B_TRANSLATE_COMMENT(
+			"Burning complete. Burn another disc?",
+			"Status notification"));
+
+		BNotification burnSuccess(B_INFORMATION_NOTIFICATION);
+		burnSuccess.SetGroup("BurnItNow");
+		burnSuccess.SetTitle(B_TRANSLATE_COMMENT("Burning image",
+			"Notification title"));
+		burnSuccess.SetContent(B_TRANSLATE_COMMENT("Burning finished!",
+			"Notification content"));
+		burnSuccess.SetMessageID(fNoteID);
+		burnSuccess.Send();
 	}
+
+	fChooseButton->SetEnabled(true);
+	fBurnButton->SetEnabled(true);
+
+	fAction = IDLE;
+	fAbort = 0;
+	fSizeView->HideBufferFill();
+	BString summary = BufferSummary(fParser.Buffers());
+	if (!summary.IsEmpty())
+		fOutputView->AddLine(summary);
+	fParser.Reset();
+}
+
+
+void
+CompilationImageView::_CheckFit(int32 action, int64 sectors)
+{
+	// Each drive that burns is asked about its disc first, _FitChecked()
+	// goes on with "action"
+	if (fFitPipeline != NULL)
+		return;
+
+	sdevice drives[MAX_DEVICES];
+	int32 driveCount = fWindowParent->GetBurnDevices(drives);
+
+	BMessage* message = new BMessage(kFitChecked);
+	message->AddInt32("action", action);
+	fFitPipeline = new JobPipeline(new BInvoker(message, this));
+	for (int32 i = 0; i < driveCount; i++) {
+		BString device("dev=");
+		device.Append(drives[i].number.String());
+		fFitPipeline->AddStage(new MediaFitStage(device, sectors));
+	}
+	fFitPipeline->Start();
+
+	fInfoView->SetLabel(B_TRANSLATE_COMMENT(
+		"Checking the disc" B_UTF8_ELLIPSIS, "Status notification"));
 }
 
 
@@ -338,6 +449,64 @@ CompilationImageView::_ChooseImage()
 }
 
 
+void
+CompilationImageView::_FitChecked(BMessage* message)
+{
+	int32 status;
+	if (message->FindInt32("pipeline_exit", &status) != B_OK)
+		return;
+
+	fFitPipeline->PostMessage(B_QUIT_REQUESTED);
+	fFitPipeline = NULL;
+
+	int32 action = message->GetInt32("action", kBurnButton);
+	if (status == B_DEVICE_FULL) {
+		BMessage results;
+		message->FindMessage("results", &results);
+		DiscTooSmallAlert(results);
+
+		fInfoView->SetLabel(B_TRANSLATE_COMMENT(
+			"The data doesn't fit on the disc", "Status notification"));
+		return;
+	}
+
+	// Anything else is left to cdrecord
+	fFitChecked = true;
+	_Burn();
+}
+
+
+void
+CompilationImageView::_MultiBurnOutput(BMessage* message)
+{
+	BString output;
+	bool done = fMultiBurner->ParseOutput(message, output);
+	if (!output.IsEmpty()) {
+		fOutputView->AddText(output.String());
+	}
+
+	if (!done) {
+		fInfoView->SetLabel(fMultiBurner->Status());
+		fProgress = fMultiBurner->Progress();
+		fETAtime = fMultiBurner->ETA();
+		if (message->HasString("line"))
+			_UpdateProgress(B_TRANSLATE_COMMENT("Burning image",
+				"Notification title"));
+		return;
+	}
+
+	if (fMultiBurner->DiscTooSmall())
+		fAbort = SMALLDISC;
+
+	int32 failed = fMultiBurner->CountFailed();
+	_BurnFinished(failed);
+
+	// Show which of the drives failed
+	if (failed > 0)
+		fInfoView->SetLabel(fMultiBurner->Status());
+}
+
+
 void
 CompilationImageView::_OpenImage(BMessage* message)
 {
@@ -363,14 +532,14 @@ CompilationImageView::_OpenImage(BMessage* message)
 		BEntry entry(&ref, true);	// also accept symlinks
 		fImagePath->SetTo(&entry);
 		fPathView->SetText(fImagePath->Path());
-		fOutputView->SetText(NULL);
+		fOutputView->Clear();
 		fBurnButton->SetEnabled(true);
 
 		if (fBurnerThread != NULL)
 			delete fBurnerThread;
 
 		fAction = BUILDING;	// flag we're opening ISO
-		fOutputView->SetText(NULL);
+		fOutputView->Clear();
 
 		fBurnerThread = new CommandThread(NULL,
 			new BInvoker(new BMessage(kBuildOutput), this));
@@ -388,19 +557,11 @@ CompilationImageView::_OpenOutput(BMessage* message)
 {
 	BString data;
 
-	if (message->FindString("line", &data) == B_OK) {
-		BString text = fOutputView->Text();
-		int32 modified = fParser.ParseIsoinfoLine(text, data);
-		if (modified == NOCHANGE) {
-			data << "\n";
-			fOutputView->Insert(data.String());
-			fOutputView->ScrollBy(0.0, 50.0);
-		} else {
-			if (modified == PERCENT)
-				_UpdateProgress("");
-			fOutputView->SetText(text);
-			fOutputView->ScrollTo(0.0, 1000000.0);
-		}
+	for (int32 i = 0; message->FindString("line", i, &data) == B_OK; i++) {
+		ParseEvent event = fParser.ParseIsoinfoLine(data);
+		if (event.result == PERCENT)
+			_UpdateProgress("");
+		fOutputView->AddLine(data, event.replaceLine);
 	}
 	int32 code = -1;
 	if (message->FindInt32("thread_exit", &code) == B_OK) {
@@ -419,15 +580,8 @@ CompilationImageView::_OpenOutput(BMessage* message)
 void
 CompilationImageView::_UpdateProgress(const char* title)
 {
-	BNotification burnProgress(B_PROGRESS_NOTIFICATION);
-	burnProgress.SetGroup("BurnItNow");
-	burnProgress.SetTitle(title);
-	burnProgress.SetContent(fETAtime);
-	burnProgress.SetProgress(fProgress);
-	burnProgress.SetMessageID(fNoteID);
-	burnProgress.Send();
-
-	_UpdateSizeBar();
+	if (fProgressController.Update(fNoteID, title, fETAtime, fProgress))
+		_UpdateSizeBar();
 }
 
 
@@ -8,16 +8,19 @@
 #include <Button.h>
 #include <FilePanel.h>
 #include <SeparatorView.h>
-#include <TextView.h>
 #include <View.h>
 
 #include "BurnWindow.h"
 #include "CompilationShared.h"
+#include "LogView.h"
 #include "OutputParser.h"
+#include "ProgressController.h"
 #include "SizeView.h"
 
 
 class CommandThread;
+class JobPipeline;
+class MultiBurner;
 
 
 class ImageRefFilter : public BRefFilter {
@@ -42,18 +45,24 @@ public:
 
 private:
 	void 			_Burn();
+	void			_BurnFinished(int32 code);
 	void 			_BurnOutput(BMessage* message);
+	void			_CheckFit(int32 action, int64 sectors);
 	void 			_ChooseImage();
+	void			_FitChecked(BMessage* message);
+	void			_MultiBurnOutput(BMessage* message);
 	void 			_OpenImage(BMessage* message);
 	void 			_OpenOutput(BMessage* message);
 	void			_UpdateProgress(const char* title);
 	void			_UpdateSizeBar();
 
 	CommandThread* 	fBurnerThread;
+	MultiBurner*	fMultiBurner;
+	JobPipeline*	fFitPipeline;
 	BurnWindow*		fWindowParent;
 
 	BFilePanel* 	fOpenPanel;
-	BTextView*		fOutputView;
+	LogView*		fOutputView;
 	BSeparatorView*	fInfoView;
 	PathView*		fPathView;
 	BPath* 			fImagePath;
@@ -66,10 +75,12 @@ private:
 	int32			fID;
 	float			fProgress;
 	BString			fETAtime;
+	ProgressController fProgressController;
 	OutputParser	fParser;
 
 	int32			fAbort;
 	int32			fAction;
+	bool			fFitChecked;
 };
 
 
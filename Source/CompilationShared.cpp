@@ -3,7 +3,10 @@
  * Distributed under the terms of the MIT License.
  */
 #include <compat/sys/stat.h>
+#include <ctype.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <string>
 
 #include <Alert.h>
@@ -17,13 +20,44 @@
 #include <StringList.h>
 #include <Volume.h>
 
+#include "CommandThread.h"
 #include "CompilationShared.h"
 #include "Constants.h"
+#include "SizeView.h"
 
 #undef B_TRANSLATION_CONTEXT
 #define B_TRANSLATION_CONTEXT "Helpers"
 
 
+BString
+BufferSummary(const BufferStats& buffers)
+{
+	BString summary;
+	if (buffers.fifoEmpty > 0) {
+		summary = B_TRANSLATE_COMMENT("Warning: The fifo ran empty %count% "
+			"times. Should the disc not work, try a lower burn speed.",
+			"Burn output; don't translate the variable %count%");
+		summary.ReplaceFirst("%count%", BString() << buffers.fifoEmpty);
+	} else if (buffers.fifoLow) {
+		summary = B_TRANSLATE_COMMENT("Warning: The fifo kept running low "
+			"(down to %fill%%). Next time, try a lower burn speed.",
+			"Burn output; don't translate the variable %fill%");
+		summary.ReplaceFirst("%fill%", BString() << buffers.minFifoFill);
+	}
+
+	if (buffers.underruns > 0) {
+		BString underruns(B_TRANSLATE_COMMENT("The drive predicted %count% "
+			"possible buffer underruns.",
+			"Burn output; don't translate the variable %count%"));
+		underruns.ReplaceFirst("%count%", BString() << buffers.underruns);
+		if (!summary.IsEmpty())
+			summary << " ";
+		summary << underruns;
+	}
+	return summary;
+}
+
+
 bool
 CheckFreeSpace(int64 size, const char* cache)
 {
@@ -67,39 +101,23 @@ DirRefFilter::Filter(const entry_ref* ref, BNode* node,
 }
 
 
-int32
-FolderSizeCount(void* arg)
+void
+DiscTooSmallAlert(const BMessage& results)
 {
-	BMessage* msg = static_cast<BMessage *>(arg);
-
-	BString path;
-	BMessenger from;
-	msg->FindString("path", &path);
-	msg->FindMessenger("from", &from);
-
-	off_t folderSize = 0;
-	BPath folder(path);
-	if (folder.InitCheck() == B_OK) {
-	    // command to be executed
-	    std::string cmd("du -sb \"");
-	    cmd.append(path);
-	    cmd.append("\" | cut -f1 2>&1");
-	
-	    // execute above command and get the output
-	    FILE *stream = popen(cmd.c_str(), "r");
-	    if (stream) {
-	        const int max_size = 256;
-	        char readbuf[max_size];
-	        if (fgets(readbuf, max_size, stream) != NULL)
-	            folderSize = atoll(readbuf);
-	        pclose(stream);            
-	    }
-	}
-	msg = new BMessage(kSetFolderSize);
-	msg->AddInt64("foldersize", folderSize / 1024); // size in KiB
-	from.SendMessage(msg);
+	char needed[B_PATH_NAME_LENGTH];
+	string_for_size(results.GetInt64("needed_sectors", 0) * 2048, needed,
+		sizeof(needed));
+	char room[B_PATH_NAME_LENGTH];
+	string_for_size(results.GetInt64("disc_sectors", 0) * 2048, room,
+		sizeof(room));
 
-	return 0;
+	BString text(B_TRANSLATE(
+		"The data doesn't fit on the disc in the drive. It needs %needed%, "
+		"but there's only room for %room%.\n\n"
+		"Insert a larger disc, or leave out some of the data."));
+	text.ReplaceFirst("%needed%", needed);
+	text.ReplaceFirst("%room%", room);
+	(new BAlert("DiscTooSmallAlert", text, B_TRANSLATE("OK")))->Go();
 }
 
 
@@ -167,3 +185,211 @@ PathView::MouseDown(BPoint position)
 
 	BStringView::MouseDown(position);
 }
+
+
+ImageSizeStage::ImageSizeStage(const BStringList& options, const char* folder)
+	:
+	JobStage("image-size", 1.0f, kMkisofsTimeout),
+	fOptions(options),
+	fFolder(folder),
+	fSectors(0)
+{
+}
+
+
+status_t
+ImageSizeStage::Prepare(CommandThread* thread, const BMessage& results)
+{
+	thread->SetSeparateStreams(true);
+	thread->AddArgument("mkisofs");
+	for (int32 i = 0; i < fOptions.CountStrings(); i++)
+		thread->AddArgument(fOptions.StringAt(i));
+
+	thread->AddArgument("-print-size")
+		->AddArgument("-quiet")
+		->AddArgument(fFolder);
+	return B_OK;
+}
+
+
+float
+ImageSizeStage::ParseLine(const BString& line, int32 stream,
+	BMessage& results)
+{
+	// The number of 2048 byte sectors is written to stdout on its own line
+	// if that isn't a terminal, and always to stderr as part of a message
+	const char* text = line.String();
+	const char* total = strstr(text,
+		"Total extents scheduled to be written =");
+	if (total != NULL)
+		text = strchr(total, '=') + 1;
+
+	while (*text == ' ')
+		text++;
+	if (!isdigit(*text))
+		return -1.0f;
+
+	const char* end = text;
+	while (isdigit(*end))
+		end++;
+	if (*end == '\0' || total != NULL)
+		fSectors = strtoll(text, NULL, 10);
+
+	return -1.0f;
+}
+
+
+status_t
+ImageSizeStage::Finish(int32 exitCode, BMessage& results)
+{
+	if (exitCode != 0 || fSectors <= 0)
+		return B_ERROR;
+
+	results.AddInt64("image_sectors", fSectors);
+	return B_OK;
+}
+
+
+MediaFitStage::MediaFitStage(const BString& device, int64 sectors)
+	:
+	JobStage("media-info", 1.0f, kCdrecordTimeout),
+	fDevice(device),
+	fSectors(sectors),
+	fRemaining(-1),
+	fProgress(0),
+	fParser(fProgress, fETAtime)
+{
+}
+
+
+status_t
+MediaFitStage::Prepare(CommandThread* thread, const BMessage& results)
+{
+	thread->SetSeparateStreams(true);
+	thread->AddArgument("cdrecord")
+		->AddArgument("-media-info")
+		->AddArgument(fDevice);
+	return B_OK;
+}
+
+
+float
+MediaFitStage::ParseLine(const BString& line, int32 stream,
+	BMessage& results)
+{
+	fParser.ParseMediaRemainingLine(fRemaining, line);
+	return -1.0f;
+}
+
+
+status_t
+MediaFitStage::Finish(int32 exitCode, BMessage& results)
+{
+	int64 sectors = fSectors;
+	if (sectors <= 0)
+		sectors = results.GetInt64("image_sectors", 0);
+
+	// No disc, or a closed one, that's for cdrecord to tell
+	if (exitCode != 0 || fRemaining < 0 || sectors <= 0
+		|| sectors + kPadSectors <= fRemaining)
+		return B_OK;
+
+	// Only the disc that's too small is told, when several are checked
+	results.AddInt64("disc_sectors", fRemaining);
+	results.AddInt64("needed_sectors", sectors + kPadSectors);
+	return B_DEVICE_FULL;
+}
+
+
+OnTheFlyBurnStage::OnTheFlyBurnStage(const BStringList& options,
+	const char* folder, const BStringList& burnArguments)
+	:
+	JobStage("cdrecord", 20.0f, kCdrecordTimeout),
+	fOptions(options),
+	fFolder(folder),
+	fBurnArguments(burnArguments),
+	fProgress(0),
+	fParser(fProgress, fETAtime)
+{
+}
+
+
+status_t
+OnTheFlyBurnStage::Prepare(CommandThread* thread, const BMessage& results)
+{
+	int64 sectors = results.GetInt64("image_sectors", 0);
+	if (sectors <= 0)
+		return B_BAD_VALUE;
+
+	BObjectList<BString>* image = new BObjectList<BString>(10, true);
+	image->AddItem(new BString("mkisofs"));
+	for (int32 i = 0; i < fOptions.CountStrings(); i++)
+		image->AddItem(new BString(fOptions.StringAt(i)));
+	image->AddItem(new BString("-quiet"));
+	image->AddItem(new BString(fFolder));
+	thread->SetInputCommand(image);
+	thread->SetSeparateStreams(true);
+
+	for (int32 i = 0; i < fBurnArguments.CountStrings(); i++)
+		thread->AddArgument(fBurnArguments.StringAt(i));
+
+	// cdrecord has to know the size of a track it reads from stdin up front
+	BString size;
+	size.SetToFormat("tsize=%" B_PRId64 "s", sectors);
+	thread->AddArgument(size)
+		->AddArgument("-");
+
+	fParser.Reset();
+	return B_OK;
+}
+
+
+float
+OnTheFlyBurnStage::ParseLine(const BString& line, int32 stream,
+	BMessage& results)
+{
+	ParseEvent event = fParser.ParseCdrecordLine(line, stream);
+	if (event.result == PERCENT)
+		return event.progress;
+
+	return -1.0f;
+}
+
+
+void
+ShowBufferFill(const ParseEvent& event, const BufferStats& buffers,
+	SizeView* sizeView, LogView* output)
+{
+	if (event.fifoFill < 0 && event.bufferFill < 0)
+		return;
+
+	sizeView->ShowBufferFill(event.fifoFill, event.bufferFill,
+		buffers.fifoLow);
+	if (event.fifoWarning) {
+		// Goes above the progress line, which is replaced by the next one
+		BString progress = output->LastLine();
+		output->AddLine(B_TRANSLATE_COMMENT("Warning: The fifo keeps running "
+			"low, the data may not come in fast enough. The burn could fail "
+			"with a buffer underrun.", "Burn output"), true);
+		output->AddLine(progress);
+	}
+}
+
+
+bool
+StopStalled(BMessage* message, CommandThread* thread, LogView* output)
+{
+	bigtime_t idleTime;
+	if (message->FindInt64("stalled", &idleTime) != B_OK)
+		return false;
+
+	if (thread != NULL)
+		thread->Stop();
+
+	BString text(B_TRANSLATE_COMMENT("The command has written nothing for "
+		"%minutes% minutes and seems to hang. It was stopped.",
+		"Burn output; don't translate the variable %minutes%"));
+	text.ReplaceFirst("%minutes%", BString() << idleTime / 60000000);
+	output->AddLine(text);
+	return true;
+}
@@ -7,8 +7,13 @@
 
 #include <FilePanel.h>
 #include <SupportDefs.h>
+#include <StringList.h>
 #include <StringView.h>
 
+#include "JobPipeline.h"
+#include "LogView.h"
+#include "OutputParser.h"
+
 
 class DirRefFilter : public BRefFilter {
 public:
@@ -21,6 +26,7 @@ public:
 
 
 class BurnWindow;
+class SizeView;
 
 class PathView : public BStringView {
 public:
@@ -31,8 +37,98 @@ public:
 };
 
 
+// The stages of burning on-the-fly
+enum {
+	kImageSizeStage = 0,
+	kMediaFitStage,
+	kOnTheFlyBurnStage
+};
+
+
+// Gets the size of the image mkisofs would build with "options" from
+// "folder", and adds it as "image_sectors" to the results
+class ImageSizeStage : public JobStage {
+public:
+					ImageSizeStage(const BStringList& options,
+						const char* folder);
+
+	virtual	status_t Prepare(CommandThread* thread, const BMessage& results);
+	virtual	float	ParseLine(const BString& line, int32 stream,
+						BMessage& results);
+	virtual	status_t Finish(int32 exitCode, BMessage& results);
+
+private:
+	BStringList		fOptions;
+	BString			fFolder;
+	int64			fSectors;
+};
+
+
+// Finds out with "cdrecord -media-info" how much room is left on the disc
+// in "device", and fails with B_DEVICE_FULL if an image of "sectors" doesn't
+// fit, with the padding of the burn. Without "sectors", the "image_sectors"
+// of an ImageSizeStage are used. When it doesn't fit, the room is added as
+// "disc_sectors" and the image with padding as "needed_sectors". Without a
+// disc, or when its room isn't known, it passes, and cdrecord has the last
+// word.
+class MediaFitStage : public JobStage {
+public:
+					MediaFitStage(const BString& device, int64 sectors = 0);
+
+	virtual	status_t Prepare(CommandThread* thread, const BMessage& results);
+	virtual	float	ParseLine(const BString& line, int32 stream,
+						BMessage& results);
+	virtual	status_t Finish(int32 exitCode, BMessage& results);
+
+private:
+	BString			fDevice;
+	int64			fSectors;
+	int64			fRemaining;
+	float			fProgress;
+	BString			fETAtime;
+	OutputParser	fParser;
+};
+
+
+// Burns the image mkisofs builds with "options" from "folder" while it is
+// built, without writing it to the disk. "burnArguments" is the cdrecord
+// command line, up to the size of the track and the input file, which are
+// added here. Needs the "image_sectors" of an ImageSizeStage.
+class OnTheFlyBurnStage : public JobStage {
+public:
+					OnTheFlyBurnStage(const BStringList& options,
+						const char* folder, const BStringList& burnArguments);
+
+	virtual	status_t Prepare(CommandThread* thread, const BMessage& results);
+	virtual	float	ParseLine(const BString& line, int32 stream,
+						BMessage& results);
+
+private:
+	BStringList		fOptions;
+	BString			fFolder;
+	BStringList		fBurnArguments;
+	float			fProgress;
+	BString			fETAtime;
+	OutputParser	fParser;
+};
+
+
+// Says how cdrecord's fifo did during a burn, if there were problems.
+// Empty otherwise.
+BString BufferSummary(const BufferStats& buffers);
 bool CheckFreeSpace(int64 size, const char* cache);
-int32 FolderSizeCount(void* arg);
+// Tells that the image doesn't fit on the disc, with the "results" of a
+// MediaFitStage
+void DiscTooSmallAlert(const BMessage& results);
 BString	GetExtension(const entry_ref* ref);
+// Shows the fill levels of a cdrecord progress line in "sizeView", and adds
+// a warning to "output" when the fifo starts to run low. Call it after the
+// line was added to "output".
+void ShowBufferFill(const ParseEvent& event, const BufferStats& buffers,
+	SizeView* sizeView, LogView* output);
+// Stops the command of "thread" if "message" is its "stalled" notice, and
+// tells so in "output". Without a "thread", it's only told, a JobPipeline
+// stops its commands itself. Returns whether the command stalled.
+bool StopStalled(BMessage* message, CommandThread* thread, LogView* output);
 
 #endif // COMPILATIONSHARED_H
@@ -35,8 +35,9 @@ enum {
 	BLANKING
 };
 
-// flags from the OutputParser
+// flags from the OutputParser, and of a command that stalled
 enum {
+	STALLED = -3,
 	INVALIDWAV = -2,
 	SMALLDISC = -1,
 	NOCHANGE = 0,
@@ -51,7 +52,10 @@ const int32 kOpenCacheFolder = 'Ocfo';
 const int32 kChooseCacheFolder = 'Cusd';
 const int32 kCacheQuit = 'Ccqt';
 const int32 kClearCache = 'Cche';
+const int32 kParallelRead = 'Prrd';
 const int32 kSpeedSlider = 'Sped';
+const int32 kOnTheFly = 'OtfC';
+const int32 kExtraDevice = 'XDev';
 
 const int32 kTrackSelection = 'Tsel';
 const int32 kTrackPlayback = 'Tply';
@@ -70,7 +74,10 @@ const int32 kBurnOutput = 'BrnO';
 
 const int32 kBuildButton = 'BilB';
 const int32 kBuildOutput = 'BilO';
-const int32 kGetImageInfoOutput = 'ImgO';
+
+const int32 kPipelineStart = 'PplS';
+const int32 kPipelineStop = 'PplQ';
+const int32 kStageOutput = 'StgO';
 
 const int32 kBlankButton = 'BlnB';
 const int32 kBlankOutput = 'BlnO';
@@ -81,6 +88,10 @@ const int32 kPopupClosed = 'popc';
 
 const int32 kCalculateSize = 'clcs';
 const int32 kSetFolderSize = 'stsz';
+const int32 kIndexFolder = 'IdxF';
+const int32 kIndexSend = 'IdxS';
+const int32 kImageSize = 'ImgS';
+const int32 kFitChecked = 'FitC';
 
 const uint32 kDeviceChange[MAX_DEVICES]
 	= { 'DVC0', 'DVC1', 'DVC2', 'DVC3', 'DVC4' };
@@ -110,6 +121,17 @@ static const float sizeCD900[] = { 1023257, 890999 };
 static const float sizeDVD5[] = { 4592762, 4592762 };
 static const float sizeDVD9[] = { 8545894, 8545894 };
 
+// cdrecord pads data tracks with this many 2 KiB sectors ("padsize=63s"),
+// they take room on the disc as well
+static const int32 kPadSectors = 63;
+
+// Time without any output after which a command is stopped as stalled.
+// cdrecord says nothing while it fixates a disc, and mkisofs nothing while
+// it goes through the folders with "-quiet".
+static const bigtime_t kCdrecordTimeout = 10 * 60 * 1000000LL;
+static const bigtime_t kMkisofsTimeout = 10 * 60 * 1000000LL;
+static const bigtime_t kReadcdTimeout = 5 * 60 * 1000000LL;
+
 // constants
 static const BString kWebsiteUrl = "https://github.com/HaikuArchives/BurnItNow";
 static const char kAppSignature[] = "application/x-vnd.haikuarchives-BurnItNow";
@@ -117,6 +139,7 @@ static const char kSettingsFile[] = "BurnItNow_settings";
 static const char kCacheFileClone[] = "burnitnow_clone.iso";
 static const char kCacheFileDVD[] = "burnitnow_dvd.iso";
 static const char kCacheFileData[] = "burnitnow_data.iso";
+static const char kCacheFileDataSnapshot[] = "burnitnow_data.snapshot";
 static const char kCacheFolderAudioClone[] = "burnitnow_clone_wavs";
 
 static const char kCopyright[] = "2010-2017";
@@ -0,0 +1,316 @@
+/*
+ * Copyright 2026, BurnItNow Team. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "FolderScanner.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+
+
+// Totals are added up per thread, and made visible after this many
+// entries, so that a huge folder doesn't keep the size from moving
+static const int32 kFlushEntries = 256;
+
+
+FolderScanner::FolderScanner()
+	:
+	fListener(NULL),
+	fNextIndex(0),
+	fWork(-1),
+	fDone(-1),
+	fPending(0),
+	fStopped(0),
+	fFinished(false),
+	fSize(0),
+	fFileCount(0),
+	fDirectoryCount(0)
+{
+}
+
+
+FolderScanner::~FolderScanner()
+{
+	Stop();
+	Wait();
+
+	for (size_t i = 0; i < fQueues.size(); i++)
+		delete fQueues[i];
+}
+
+
+void
+FolderScanner::SetListener(Listener* listener)
+{
+	fListener = listener;
+}
+
+
+status_t
+FolderScanner::Start(const char* path, int32 workers)
+{
+	if (!fThreads.empty())
+		return B_BUSY;
+
+	struct stat info;
+	if (stat(path, &info) != 0)
+		return errno;
+	if (!S_ISDIR(info.st_mode))
+		return B_NOT_A_DIRECTORY;
+
+	if (workers <= 0) {
+		system_info systemInfo;
+		get_system_info(&systemInfo);
+		workers = max_c(systemInfo.cpu_count, 2);
+	}
+
+	fWork = create_sem(0, "folder scanner work");
+	fDone = create_sem(0, "folder scanner done");
+	if (fWork < 0 || fDone < 0) {
+		status_t status = fWork < 0 ? fWork : fDone;
+		delete_sem(fWork);
+		delete_sem(fDone);
+		return status;
+	}
+
+	for (int32 i = 0; i < workers; i++)
+		fQueues.push_back(new Queue);
+
+	fDirectoryCount = 1;
+	fQueues[0]->directories.push_back(path);
+	fPending = 1;
+	release_sem(fWork);
+
+	for (int32 i = 0; i < workers; i++) {
+		thread_id thread = spawn_thread(_Worker, "folder scanner",
+			B_LOW_PRIORITY, this);
+		if (thread < 0)
+			break;
+		fThreads.push_back(thread);
+		resume_thread(thread);
+	}
+	if (fThreads.empty()) {
+		delete_sem(fWork);
+		delete_sem(fDone);
+		fWork = fDone = -1;
+		return B_NO_MORE_THREADS;
+	}
+	return B_OK;
+}
+
+
+status_t
+FolderScanner::Wait(bigtime_t timeout)
+{
+	if (fThreads.empty() || fFinished)
+		return B_OK;
+
+	status_t status = acquire_sem_etc(fDone, 1, B_RELATIVE_TIMEOUT, timeout);
+	if (status != B_OK)
+		return status == B_WOULD_BLOCK ? B_TIMED_OUT : status;
+
+	_Join();
+	return B_OK;
+}
+
+
+void
+FolderScanner::Stop()
+{
+	// The threads still empty the queues, without reading any more folders
+	atomic_set(&fStopped, 1);
+}
+
+
+off_t
+FolderScanner::Size()
+{
+	return atomic_get64(&fSize);
+}
+
+
+int64
+FolderScanner::CountFiles()
+{
+	return atomic_get64(&fFileCount);
+}
+
+
+int64
+FolderScanner::CountDirectories()
+{
+	return atomic_get64(&fDirectoryCount);
+}
+
+
+#pragma mark -- Private Methods --
+
+
+int32
+FolderScanner::_Worker(void* data)
+{
+	FolderScanner* scanner = (FolderScanner*)data;
+	int32 index = atomic_add(&scanner->fNextIndex, 1);
+	int32 workers = scanner->fQueues.size();
+
+	// Each time the semaphore is acquired, there's a folder in one of the
+	// queues for this thread
+	while (acquire_sem(scanner->fWork) == B_OK) {
+		if (atomic_get(&scanner->fPending) == 0)
+			break;
+
+		std::string path;
+		if (!scanner->_NextDirectory(index, path))
+			continue;
+
+		if (atomic_get(&scanner->fStopped) == 0)
+			scanner->_ReadDirectory(index, path);
+
+		if (atomic_add(&scanner->fPending, -1) == 1) {
+			// That was the last one, let all others quit
+			release_sem_etc(scanner->fWork, workers, 0);
+			release_sem(scanner->fDone);
+		}
+	}
+	return 0;
+}
+
+
+bool
+FolderScanner::_NextDirectory(int32 index, std::string& path)
+{
+	// The newest of its own first, which is likely still cached, otherwise
+	// the oldest of another one, which likely has the most below it
+	int32 count = fQueues.size();
+	for (int32 i = 0; i < count; i++) {
+		Queue* queue = fQueues[(index + i) % count];
+		queue->lock.Lock();
+		if (!queue->directories.empty()) {
+			if (i == 0) {
+				path = queue->directories.back();
+				queue->directories.pop_back();
+			} else {
+				path = queue->directories.front();
+				queue->directories.pop_front();
+			}
+			queue->lock.Unlock();
+			return true;
+		}
+		queue->lock.Unlock();
+	}
+	return false;
+}
+
+
+void
+FolderScanner::_ReadDirectory(int32 index, const std::string& path)
+{
+	DIR* dir = opendir(path.c_str());
+	if (dir == NULL) {
+		// What can't be read isn't counted, like du does
+		return;
+	}
+
+	Queue* queue = fQueues[index];
+	int fd = dirfd(dir);
+
+	struct stat folder;
+	std::vector<Entry> listed;
+	if (fListener != NULL) {
+		if (fstat(fd, &folder) != 0) {
+			closedir(dir);
+			return;
+		}
+		fListener->FolderOpened(folder.st_dev, folder.st_ino);
+	}
+
+	int64 size = 0;
+	int64 files = 0;
+	int32 directories = 0;
+	int32 entries = 0;
+
+	while (dirent* entry = readdir(dir)) {
+		if (strcmp(entry->d_name, ".") == 0
+			|| strcmp(entry->d_name, "..") == 0)
+			continue;
+
+		struct stat info;
+		if (fstatat(fd, entry->d_name, &info, AT_SYMLINK_NOFOLLOW) != 0)
+			continue;
+
+		if (S_ISDIR(info.st_mode)) {
+			queue->lock.Lock();
+			queue->directories.push_back(path + "/" + entry->d_name);
+			queue->lock.Unlock();
+			directories++;
+		} else if (S_ISREG(info.st_mode)) {
+			// Hard links are the same file
+			if (info.st_nlink <= 1 || _FirstLink(info.st_dev, info.st_ino)) {
+				size += info.st_size;
+				files++;
+			}
+		} else
+			continue;
+
+		if (fListener != NULL) {
+			Entry found = { entry->d_name, info.st_dev, info.st_ino,
+				info.st_size, info.st_nlink, S_ISDIR(info.st_mode) };
+			listed.push_back(found);
+		}
+
+		if (++entries == kFlushEntries) {
+			_AddTotals(size, files, directories);
+			size = files = 0;
+			directories = entries = 0;
+		}
+	}
+	closedir(dir);
+
+	if (fListener != NULL)
+		fListener->FolderRead(folder.st_dev, folder.st_ino, listed);
+
+	_AddTotals(size, files, directories);
+}
+
+
+void
+FolderScanner::_AddTotals(int64 size, int64 files, int32 directories)
+{
+	atomic_add64(&fSize, size);
+	atomic_add64(&fFileCount, files);
+	if (directories > 0) {
+		// They are in the queue already, now others may take them
+		atomic_add64(&fDirectoryCount, directories);
+		atomic_add(&fPending, directories);
+		release_sem_etc(fWork, directories, 0);
+	}
+}
+
+
+bool
+FolderScanner::_FirstLink(dev_t device, ino_t node)
+{
+	int32 shard = node % kLinkShards;
+	fLinkLocks[shard].Lock();
+	bool first = fLinks[shard].insert(std::make_pair(device, node)).second;
+	fLinkLocks[shard].Unlock();
+	return first;
+}
+
+
+void
+FolderScanner::_Join()
+{
+	for (size_t i = 0; i < fThreads.size(); i++) {
+		status_t exitValue;
+		wait_for_thread(fThreads[i], &exitValue);
+	}
+	delete_sem(fWork);
+	delete_sem(fDone);
+	fWork = fDone = -1;
+	fFinished = true;
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2026, BurnItNow Team. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _FOLDERSCANNER_H_
+#define _FOLDERSCANNER_H_
+
+
+#include <Locker.h>
+#include <OS.h>
+#include <SupportDefs.h>
+
+#include <sys/types.h>
+
+#include <deque>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+// Adds up the size of all files in a folder, with several threads. Each of
+// them reads folders from a queue of its own, and takes them from the
+// others when it runs out (work stealing). The totals can be asked for
+// while it runs. Hard links of a file only count once.
+//
+// A listener can be told about each folder and what is in it, to keep an
+// index of its own.
+class FolderScanner {
+public:
+	// A file or folder in a folder, other kinds of entries are left out
+	struct Entry {
+		std::string		name;
+		dev_t			device;
+		ino_t			node;
+		off_t			size;
+		nlink_t			links;
+		bool			folder;
+	};
+
+	// Called by the scanning threads, at the same time
+	class Listener {
+	public:
+		virtual			~Listener() {}
+
+		// Before the folder is read
+		virtual	void	FolderOpened(dev_t device, ino_t folder) = 0;
+		virtual	void	FolderRead(dev_t device, ino_t folder,
+							const std::vector<Entry>& entries) = 0;
+	};
+
+					FolderScanner();
+	// Stops the threads, and waits for them to quit
+					~FolderScanner();
+
+	// Has to be set before Start()
+	void			SetListener(Listener* listener);
+
+	// "workers" is the number of threads, by default one for each CPU
+	status_t		Start(const char* path, int32 workers = 0);
+	// Returns B_TIMED_OUT if the scan isn't done within "timeout"
+	status_t		Wait(bigtime_t timeout = B_INFINITE_TIMEOUT);
+	void			Stop();
+
+	// What was found so far, the size is that of the files
+	off_t			Size();
+	int64			CountFiles();
+	int64			CountDirectories();
+
+private:
+	struct Queue {
+		BLocker					lock;
+		std::deque<std::string>	directories;
+	};
+
+	enum {
+		kLinkShards = 16
+	};
+
+	static int32	_Worker(void* data);
+
+	bool			_NextDirectory(int32 index, std::string& path);
+	void			_ReadDirectory(int32 index, const std::string& path);
+	void			_AddTotals(int64 size, int64 files, int32 directories);
+	bool			_FirstLink(dev_t device, ino_t node);
+	void			_Join();
+
+	std::vector<Queue*> fQueues;
+	std::vector<thread_id> fThreads;
+	Listener*		fListener;
+	int32			fNextIndex;
+	sem_id			fWork;
+	sem_id			fDone;
+	int32			fPending;
+	int32			fStopped;
+	bool			fFinished;
+
+	int64			fSize;
+	int64			fFileCount;
+	int64			fDirectoryCount;
+
+	// Files with more than one link that were counted already
+	BLocker			fLinkLocks[kLinkShards];
+	std::set<std::pair<dev_t, ino_t> > fLinks[kLinkShards];
+};
+
+
+#endif	// _FOLDERSCANNER_H_
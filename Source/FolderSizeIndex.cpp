@@ -0,0 +1,598 @@
+/*
+ * Copyright 2026, BurnItNow Team. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "FolderSizeIndex.h"
+
+#include <Autolock.h>
+#include <Entry.h>
+#include <NodeMonitor.h>
+#include <Path.h>
+
+#include <sys/resource.h>
+
+#include "Constants.h"
+
+
+// How often the size is sent while a folder is read
+static const bigtime_t kProgressInterval = 250000;
+
+// The most node monitors a team can have
+static const rlim_t kMaxNodeMonitors = 65536;
+
+
+FolderSizeIndex::FolderSizeIndex(BInvoker* invoker)
+	:
+	BLooper("folder size index"),
+	fInvoker(invoker),
+	fGeneration(0),
+	fFolderGeneration(0),
+	fWatched(true),
+	fSendPending(false),
+	fSentSize(-1),
+	fSentFiles(-1)
+{
+}
+
+
+FolderSizeIndex::~FolderSizeIndex()
+{
+	stop_watching(this);
+	delete fInvoker;
+}
+
+
+int32
+FolderSizeIndex::SetFolder(const char* path)
+{
+	// A folder still being read doesn't matter anymore
+	int32 generation = atomic_add(&fGeneration, 1) + 1;
+
+	BMessage message(kIndexFolder);
+	message.AddString("path", path);
+	message.AddInt32("generation", generation);
+	PostMessage(&message);
+
+	return generation;
+}
+
+
+void
+FolderSizeIndex::Stop()
+{
+	atomic_add(&fGeneration, 1);
+}
+
+
+void
+FolderSizeIndex::MessageReceived(BMessage* message)
+{
+	switch (message->what) {
+		case kIndexFolder:
+			_SetFolder(message->GetString("path", ""),
+				message->GetInt32("generation", 0));
+			break;
+		case B_NODE_MONITOR:
+			_HandleNodeMonitor(message);
+			break;
+		case kIndexSend:
+		{
+			fSendPending = false;
+			std::map<node_ref, Folder>::iterator root = fFolders.find(fRoot);
+			off_t size = root != fFolders.end() ? root->second.total : 0;
+			if ((size != fSentSize || (int64)fFiles.size() != fSentFiles)
+				&& !_OutOfDate())
+				_Send(size, fFiles.size(), false);
+			break;
+		}
+		default:
+			BLooper::MessageReceived(message);
+	}
+}
+
+
+#pragma mark -- FolderScanner::Listener --
+
+
+void
+FolderSizeIndex::FolderOpened(dev_t device, ino_t folder)
+{
+	// Watched before it's read, so that nothing is missed
+	node_ref node(device, folder);
+	uint32 flags = B_WATCH_DIRECTORY;
+	if (node == fRoot)
+		flags |= B_WATCH_NAME;
+
+	BAutolock _(fLock);
+	_Watch(node, flags);
+}
+
+
+void
+FolderSizeIndex::FolderRead(dev_t device, ino_t folder,
+	const std::vector<FolderScanner::Entry>& entries)
+{
+	// The totals are counted once all is read, as folders may be read
+	// before the folder they are in
+	node_ref parentNode(device, folder);
+
+	BAutolock _(fLock);
+	Folder& parent = fFolders[parentNode];
+	for (size_t i = 0; i < entries.size(); i++) {
+		const FolderScanner::Entry& entry = entries[i];
+		node_ref node(entry.device, entry.node);
+
+		if (entry.folder) {
+			fFolders[node].parent = parentNode;
+			parent.folders.insert(node);
+			continue;
+		}
+
+		Link link = { parentNode, entry.name };
+		std::map<node_ref, File>::iterator found = fFiles.find(node);
+		if (found == fFiles.end()) {
+			File& file = fFiles[node];
+			file.size = entry.size;
+			file.links.push_back(link);
+			_Watch(node, B_WATCH_STAT);
+		} else
+			found->second.links.push_back(link);
+		parent.files.insert(node);
+	}
+}
+
+
+#pragma mark -- Private Methods --
+
+
+void
+FolderSizeIndex::_SetFolder(const char* path, int32 generation)
+{
+	_Clear();
+	fSentSize = -1;
+	fSentFiles = -1;
+	fFolderGeneration = generation;
+
+	BNode node(path);
+	if (node.GetNodeRef(&fRoot) != B_OK) {
+		fRoot = node_ref();
+		_Send(0, 0, false);
+		return;
+	}
+	node.Unset();
+	fFolders[fRoot].parent = node_ref();
+
+	status_t status = _Scan(path, true);
+	if (status == B_CANCELED) {
+		// Another folder comes next
+		return;
+	}
+	if (status != B_OK) {
+		_Clear();
+		_Send(0, 0, false);
+		return;
+	}
+
+	_Send(_Count(fRoot), fFiles.size(), false);
+}
+
+
+status_t
+FolderSizeIndex::_Scan(const char* path, bool sendProgress)
+{
+	if (_OutOfDate())
+		return B_CANCELED;
+
+	FolderScanner scanner;
+	scanner.SetListener(this);
+	status_t status = scanner.Start(path);
+	if (status != B_OK)
+		return status;
+
+	// Node monitor messages wait in the queue until it's done
+	while (scanner.Wait(kProgressInterval) == B_TIMED_OUT) {
+		if (_OutOfDate()) {
+			scanner.Stop();
+			scanner.Wait();
+			return B_CANCELED;
+		}
+		if (sendProgress)
+			_Send(scanner.Size(), scanner.CountFiles(), true);
+	}
+	return B_OK;
+}
+
+
+bool
+FolderSizeIndex::_OutOfDate()
+{
+	// Another folder was set, or the index was stopped
+	return atomic_get(&fGeneration) != fFolderGeneration;
+}
+
+
+off_t
+FolderSizeIndex::_Count(const node_ref& node)
+{
+	Folder& folder = fFolders[node];
+	off_t total = 0;
+
+	std::set<node_ref>::iterator iterator = folder.files.begin();
+	for (; iterator != folder.files.end(); iterator++) {
+		const File& file = fFiles[*iterator];
+		if (file.links[0].folder == node)
+			total += file.size;
+	}
+	iterator = folder.folders.begin();
+	for (; iterator != folder.folders.end(); iterator++)
+		total += _Count(*iterator);
+
+	folder.total = total;
+	return total;
+}
+
+
+void
+FolderSizeIndex::_Clear()
+{
+	stop_watching(this);
+	fFolders.clear();
+	fFiles.clear();
+	fRoot = node_ref();
+	fWatched = true;
+}
+
+
+void
+FolderSizeIndex::_HandleNodeMonitor(BMessage* message)
+{
+	// Changes to a folder that is about to be replaced aren't read anymore
+	if (_OutOfDate())
+		return;
+
+	int32 opcode;
+	dev_t device;
+	ino_t node;
+	if (message->FindInt32("opcode", &opcode) != B_OK
+		|| message->FindInt32("device", &device) != B_OK
+		|| message->FindInt64("node", &node) != B_OK)
+		return;
+
+	node_ref entryNode(device, node);
+	const char* name = NULL;
+	message->FindString("name", &name);
+
+	switch (opcode) {
+		case B_ENTRY_CREATED:
+		{
+			ino_t directory;
+			if (message->FindInt64("directory", &directory) == B_OK
+				&& name != NULL)
+				_EntryCreated(node_ref(device, directory), name);
+			break;
+		}
+		case B_ENTRY_REMOVED:
+		{
+			ino_t directory;
+			if (message->FindInt64("directory", &directory) == B_OK)
+				_EntryRemoved(node_ref(device, directory), entryNode, name);
+			break;
+		}
+		case B_ENTRY_MOVED:
+		{
+			ino_t fromDirectory;
+			ino_t toDirectory;
+			if (entryNode == fRoot
+				|| message->FindInt64("from directory", &fromDirectory)
+					!= B_OK
+				|| message->FindInt64("to directory", &toDirectory) != B_OK)
+				break;
+
+			node_ref from(device, fromDirectory);
+			node_ref to(device, toDirectory);
+			bool fromInside = fFolders.find(from) != fFolders.end();
+			bool toInside = fFolders.find(to) != fFolders.end();
+
+			if (fromInside && toInside
+				&& fFolders.find(entryNode) != fFolders.end()) {
+				_FolderMoved(entryNode, to);
+				break;
+			}
+
+			// Anything else is removed from where it was, and added where
+			// it is now
+			const char* fromName = NULL;
+			message->FindString("from name", &fromName);
+			if (fromInside)
+				_EntryRemoved(from, entryNode, fromName);
+			if (toInside && name != NULL)
+				_EntryCreated(to, name);
+			break;
+		}
+		case B_STAT_CHANGED:
+		{
+			int32 fields;
+			if (message->FindInt32("fields", &fields) != B_OK
+				|| (fields & B_STAT_SIZE) != 0)
+				_StatChanged(entryNode);
+			break;
+		}
+		default:
+			return;
+	}
+
+	_Changed();
+}
+
+
+void
+FolderSizeIndex::_EntryCreated(const node_ref& folder, const char* name)
+{
+	if (fFolders.find(folder) == fFolders.end())
+		return;
+
+	entry_ref ref(folder.device, folder.node, name);
+	BEntry entry(&ref);
+	struct stat info;
+	if (entry.GetStat(&info) != B_OK)
+		return;
+
+	node_ref node(info.st_dev, info.st_ino);
+	if (S_ISREG(info.st_mode)) {
+		_AddLink(node, folder, name, info.st_size);
+		return;
+	}
+	if (!S_ISDIR(info.st_mode) || fFolders.find(node) != fFolders.end())
+		return;
+
+	// A folder that is moved here may have a lot in it
+	BPath path(&entry);
+	if (path.InitCheck() != B_OK)
+		return;
+
+	fFolders[node].parent = folder;
+	fFolders[folder].folders.insert(node);
+	if (_Scan(path.Path(), false) == B_OK)
+		_AddSize(folder, _Count(node));
+}
+
+
+void
+FolderSizeIndex::_EntryRemoved(const node_ref& folder, const node_ref& node,
+	const char* name)
+{
+	if (node == fRoot) {
+		_Clear();
+		return;
+	}
+
+	std::map<node_ref, Folder>::iterator found = fFolders.find(node);
+	if (found != fFolders.end()) {
+		if (found->second.parent != folder)
+			return;
+
+		_AddSize(folder, -found->second.total);
+		fFolders[folder].folders.erase(node);
+		found->second.parent = node_ref();
+		_Forget(node);
+		return;
+	}
+
+	if (fFiles.find(node) != fFiles.end())
+		_RemoveLink(node, folder, name);
+}
+
+
+void
+FolderSizeIndex::_FolderMoved(const node_ref& node, const node_ref& to)
+{
+	Folder& folder = fFolders[node];
+	node_ref from = folder.parent;
+	if (from == to)
+		return;
+
+	_AddSize(from, -folder.total);
+	fFolders[from].folders.erase(node);
+	folder.parent = to;
+	fFolders[to].folders.insert(node);
+	_AddSize(to, folder.total);
+}
+
+
+void
+FolderSizeIndex::_StatChanged(const node_ref& node)
+{
+	std::map<node_ref, File>::iterator found = fFiles.find(node);
+	if (found == fFiles.end())
+		return;
+
+	File& file = found->second;
+	const Link& link = file.links[0];
+	entry_ref ref(link.folder.device, link.folder.node, link.name.c_str());
+	BEntry entry(&ref);
+	struct stat info;
+	if (entry.GetStat(&info) != B_OK || info.st_ino != node.node)
+		return;
+
+	_AddSize(link.folder, info.st_size - file.size);
+	file.size = info.st_size;
+}
+
+
+void
+FolderSizeIndex::_AddLink(const node_ref& node, const node_ref& folder,
+	const char* name, off_t size)
+{
+	Link link = { folder, name };
+
+	std::map<node_ref, File>::iterator found = fFiles.find(node);
+	if (found == fFiles.end()) {
+		File& file = fFiles[node];
+		file.size = size;
+		file.links.push_back(link);
+		fFolders[folder].files.insert(node);
+		_Watch(node, B_WATCH_STAT);
+		_AddSize(folder, size);
+		return;
+	}
+
+	// The scan may have found it already
+	File& file = found->second;
+	bool known = false;
+	for (size_t i = 0; i < file.links.size(); i++) {
+		if (file.links[i].folder == folder && file.links[i].name == name)
+			known = true;
+	}
+	if (!known) {
+		file.links.push_back(link);
+		fFolders[folder].files.insert(node);
+	}
+
+	_AddSize(file.links[0].folder, size - file.size);
+	file.size = size;
+}
+
+
+void
+FolderSizeIndex::_RemoveLink(const node_ref& node, const node_ref& folder,
+	const char* name)
+{
+	File& file = fFiles[node];
+
+	// Without a name, the first link in the folder goes
+	size_t index = 0;
+	while (index < file.links.size()
+		&& (file.links[index].folder != folder
+			|| (name != NULL && file.links[index].name != name)))
+		index++;
+	if (index == file.links.size())
+		return;
+
+	file.links.erase(file.links.begin() + index);
+
+	bool stillInFolder = false;
+	for (size_t i = 0; i < file.links.size(); i++) {
+		if (file.links[i].folder == folder)
+			stillInFolder = true;
+	}
+	if (!stillInFolder)
+		fFolders[folder].files.erase(node);
+
+	if (file.links.empty()) {
+		_AddSize(folder, -file.size);
+		_Unwatch(node);
+		fFiles.erase(node);
+	} else if (index == 0) {
+		// Another link counts the size now
+		_AddSize(folder, -file.size);
+		_AddSize(file.links[0].folder, file.size);
+	}
+}
+
+
+void
+FolderSizeIndex::_Forget(const node_ref& node)
+{
+	// The size was taken away from the folders above it already
+	std::map<node_ref, Folder>::iterator found = fFolders.find(node);
+	if (found == fFolders.end())
+		return;
+
+	std::set<node_ref> folders = found->second.folders;
+	std::set<node_ref> files = found->second.files;
+
+	std::set<node_ref>::iterator iterator = folders.begin();
+	for (; iterator != folders.end(); iterator++)
+		_Forget(*iterator);
+
+	for (iterator = files.begin(); iterator != files.end(); iterator++) {
+		File& file = fFiles[*iterator];
+		bool counted = file.links[0].folder == node;
+
+		for (size_t i = file.links.size(); i-- > 0;) {
+			if (file.links[i].folder == node)
+				file.links.erase(file.links.begin() + i);
+		}
+
+		if (file.links.empty()) {
+			_Unwatch(*iterator);
+			fFiles.erase(*iterator);
+		} else if (counted)
+			_AddSize(file.links[0].folder, file.size);
+	}
+
+	_Unwatch(node);
+	fFolders.erase(node);
+}
+
+
+void
+FolderSizeIndex::_AddSize(node_ref folder, off_t size)
+{
+	while (true) {
+		std::map<node_ref, Folder>::iterator found = fFolders.find(folder);
+		if (found == fFolders.end())
+			break;
+
+		found->second.total += size;
+		folder = found->second.parent;
+	}
+}
+
+
+void
+FolderSizeIndex::_Watch(const node_ref& node, uint32 flags)
+{
+	status_t status = watch_node(&node, flags, this);
+	if (status != B_OK) {
+		// The number of node monitors of a team is limited, but it can be
+		// raised
+		struct rlimit limit;
+		if (getrlimit(RLIMIT_NOVMON, &limit) == 0
+			&& limit.rlim_cur < kMaxNodeMonitors) {
+			limit.rlim_cur = min_c(limit.rlim_cur * 2, kMaxNodeMonitors);
+			limit.rlim_max = RLIM_SAVED_MAX;
+			if (setrlimit(RLIMIT_NOVMON, &limit) == 0)
+				status = watch_node(&node, flags, this);
+		}
+	}
+	if (status != B_OK)
+		fWatched = false;
+}
+
+
+void
+FolderSizeIndex::_Unwatch(const node_ref& node)
+{
+	watch_node(&node, B_STOP_WATCHING, this);
+}
+
+
+void
+FolderSizeIndex::_Changed()
+{
+	// Changes that come in one after the other are sent at once
+	if (!fSendPending) {
+		fSendPending = true;
+		PostMessage(kIndexSend);
+	}
+}
+
+
+void
+FolderSizeIndex::_Send(off_t size, int64 files, bool partial)
+{
+	BMessage message(*fInvoker->Message());
+	message.AddInt64("foldersize", size / 1024); // size in KiB
+	message.AddInt64("files", files);
+	message.AddBool("partial", partial);
+	message.AddBool("watched", fWatched);
+	message.AddInt32("generation", fFolderGeneration);
+	fInvoker->Invoke(&message);
+
+	if (!partial) {
+		fSentSize = size;
+		fSentFiles = files;
+	}
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2026, BurnItNow Team. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _FOLDERSIZEINDEX_H_
+#define _FOLDERSIZEINDEX_H_
+
+
+#include "FolderScanner.h"
+
+#include <Invoker.h>
+#include <Locker.h>
+#include <Looper.h>
+#include <Node.h>
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+
+// Knows the size of a folder, and keeps it up to date. The folder is read
+// once by a FolderScanner, and from then on, the node monitor tells about
+// each file and folder that is added, removed, moved or changes its size.
+// The total of every folder is kept, so these only need to be added to the
+// folders above.
+//
+// Copies of the invoker's message are sent with the "foldersize" in KiB and
+// the number of "files", while the folder is read with "partial" set, and
+// after each change. Hard links of a file only count once.
+// "watched" is false when there were too many files to watch them all, and
+// changes may have been missed. "generation" is the one SetFolder()
+// returned for the folder, messages with another one are about a folder
+// that was set before, and are out of date.
+// To get rid of it, call Stop() and post it a B_QUIT_REQUESTED message.
+class FolderSizeIndex : public BLooper, private FolderScanner::Listener {
+public:
+					FolderSizeIndex(BInvoker* invoker);
+	virtual			~FolderSizeIndex();
+
+	// Forgets the folder before, and reads "path". Returns the generation
+	// of the messages about it.
+	int32			SetFolder(const char* path);
+	// Stops reading a folder, it can be called from any thread
+	void			Stop();
+
+	virtual	void	MessageReceived(BMessage* message);
+
+private:
+	struct Link {
+		node_ref		folder;
+		std::string		name;
+	};
+
+	struct File {
+		off_t			size;
+		// The size is counted in the folder of the first one
+		std::vector<Link> links;
+	};
+
+	struct Folder {
+		node_ref		parent;
+		// With all folders below it
+		off_t			total;
+		std::set<node_ref> folders;
+		std::set<node_ref> files;
+	};
+
+	virtual	void	FolderOpened(dev_t device, ino_t folder);
+	virtual	void	FolderRead(dev_t device, ino_t folder,
+						const std::vector<FolderScanner::Entry>& entries);
+
+	void			_SetFolder(const char* path, int32 generation);
+	status_t		_Scan(const char* path, bool sendProgress);
+	bool			_OutOfDate();
+	off_t			_Count(const node_ref& folder);
+	void			_Clear();
+
+	void			_HandleNodeMonitor(BMessage* message);
+	void			_EntryCreated(const node_ref& folder, const char* name);
+	void			_EntryRemoved(const node_ref& folder, const node_ref& node,
+						const char* name);
+	void			_FolderMoved(const node_ref& node, const node_ref& to);
+	void			_StatChanged(const node_ref& node);
+
+	void			_AddLink(const node_ref& node, const node_ref& folder,
+						const char* name, off_t size);
+	void			_RemoveLink(const node_ref& node, const node_ref& folder,
+						const char* name);
+	void			_Forget(const node_ref& folder);
+	void			_AddSize(node_ref folder, off_t size);
+	void			_Watch(const node_ref& node, uint32 flags);
+	void			_Unwatch(const node_ref& node);
+
+	void			_Changed();
+	void			_Send(off_t size, int64 files, bool partial);
+
+	BInvoker*		fInvoker;
+	// Raised each time the folder changes or the index is stopped
+	int32			fGeneration;
+	// That of the folder in the index
+	int32			fFolderGeneration;
+	node_ref		fRoot;
+	bool			fWatched;
+	bool			fSendPending;
+	off_t			fSentSize;
+	int64			fSentFiles;
+
+	// Also filled in by the scanning threads
+	BLocker			fLock;
+	std::map<node_ref, Folder> fFolders;
+	std::map<node_ref, File> fFiles;
+};
+
+
+#endif	// _FOLDERSIZEINDEX_H_
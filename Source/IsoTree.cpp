@@ -0,0 +1,778 @@
+/*
+ * Copyright 2026, BurnItNow Team. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "IsoTree.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <utility>
+
+
+// ISO 9660 level 2 and 3 limits, the version ";1" and the separator of a
+// file name don't count
+static const size_t kMaxFileName = 30;
+static const size_t kMaxDirectoryName = 31;
+static const size_t kMaxExtension = 8;
+// In UCS-2 characters, as with the -joliet-long option of mkisofs
+static const size_t kMaxJolietName = 103;
+// Of folders, the root is the first
+static const int32 kMaxLevels = 8;
+
+
+// Maps "name" to the d-characters: A-Z, 0-9 and _
+static std::string
+d_characters(const std::string& name)
+{
+	std::string mapped;
+	for (size_t i = 0; i < name.size(); i++) {
+		unsigned char c = name[i];
+		if ((c & 0xc0) == 0x80) {
+			// One _ for each UTF-8 character, not for each byte
+			continue;
+		}
+		if (c >= 'a' && c <= 'z')
+			mapped += c - 'a' + 'A';
+		else if ((c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9'))
+			mapped += c;
+		else
+			mapped += '_';
+	}
+	return mapped;
+}
+
+
+static std::string
+iso_identifier(const std::string& base, const std::string& extension,
+	bool directory)
+{
+	if (directory)
+		return base;
+
+	return base + "." + extension + ";1";
+}
+
+
+static void
+split_identifier(const std::string& identifier, bool directory,
+	std::string& base, std::string& extension)
+{
+	if (directory) {
+		base = identifier;
+		extension.clear();
+		return;
+	}
+
+	size_t dot = identifier.find('.');
+	base = identifier.substr(0, dot);
+	extension = identifier.substr(dot + 1,
+		identifier.size() - dot - 1 - 2);
+}
+
+
+static std::string
+iso_name(const std::string& name, bool directory)
+{
+	if (directory) {
+		std::string base = d_characters(name).substr(0, kMaxDirectoryName);
+		return base.empty() ? "_" : base;
+	}
+
+	// A leading dot doesn't start an extension
+	size_t dot = name.rfind('.');
+	if (dot == 0)
+		dot = std::string::npos;
+
+	std::string base = d_characters(name.substr(0, dot));
+	std::string extension;
+	if (dot != std::string::npos)
+		extension = d_characters(name.substr(dot + 1));
+
+	if (base.size() + extension.size() > kMaxFileName) {
+		if (extension.size() > kMaxExtension)
+			extension.resize(kMaxExtension);
+		if (base.size() + extension.size() > kMaxFileName)
+			base.resize(kMaxFileName - extension.size());
+	}
+	if (base.empty() && extension.empty())
+		base = "_";
+
+	return iso_identifier(base, extension, false);
+}
+
+
+// Ends the name part of "identifier" with "number", to tell it apart from
+// another one of the same name
+static std::string
+mangle_iso_name(const std::string& identifier, bool directory, int number)
+{
+	std::string base;
+	std::string extension;
+	split_identifier(identifier, directory, base, extension);
+
+	char digits[16];
+	snprintf(digits, sizeof(digits), "%03d", number);
+	size_t maxBase = (directory ? kMaxDirectoryName
+		: kMaxFileName - extension.size()) - strlen(digits);
+	if (base.size() > maxBase)
+		base.resize(maxBase);
+
+	return iso_identifier(base + digits, extension, directory);
+}
+
+
+// Converts UTF-8 to UCS-2, characters outside of the BMP are kept as
+// surrogate pairs, like mkisofs does
+static std::vector<uint16>
+ucs2_characters(const std::string& name)
+{
+	std::vector<uint16> characters;
+	for (size_t i = 0; i < name.size();) {
+		unsigned char c = name[i];
+		uint32 code = '_';
+		size_t length = 1;
+		if (c < 0x80)
+			code = c;
+		else if ((c & 0xe0) == 0xc0)
+			length = 2, code = c & 0x1f;
+		else if ((c & 0xf0) == 0xe0)
+			length = 3, code = c & 0x0f;
+		else if ((c & 0xf8) == 0xf0)
+			length = 4, code = c & 0x07;
+
+		if (i + length > name.size())
+			length = 1, code = '_';
+		for (size_t j = 1; j < length; j++) {
+			unsigned char next = name[i + j];
+			if ((next & 0xc0) != 0x80) {
+				length = 1;
+				code = '_';
+				break;
+			}
+			code = (code << 6) | (next & 0x3f);
+		}
+		i += length;
+
+		// Not allowed in Joliet names
+		if (code < 0x20 || code == '*' || code == '/' || code == ':'
+			|| code == ';' || code == '?' || code == '\\')
+			code = '_';
+
+		if (code >= 0x10000) {
+			code -= 0x10000;
+			characters.push_back(0xd800 | (code >> 10));
+			characters.push_back(0xdc00 | (code & 0x3ff));
+		} else
+			characters.push_back(code);
+	}
+	return characters;
+}
+
+
+static std::string
+joliet_identifier(std::vector<uint16> characters, bool directory)
+{
+	if (!directory) {
+		characters.push_back(';');
+		characters.push_back('1');
+	}
+
+	std::string identifier;
+	for (size_t i = 0; i < characters.size(); i++) {
+		identifier += (char)(characters[i] >> 8);
+		identifier += (char)(characters[i] & 0xff);
+	}
+	return identifier;
+}
+
+
+static std::vector<uint16>
+joliet_characters(const std::string& name, int number)
+{
+	std::vector<uint16> characters = ucs2_characters(name);
+
+	size_t maxLength = kMaxJolietName;
+	char digits[16] = "";
+	if (number > 0) {
+		snprintf(digits, sizeof(digits), "%03d", number);
+		maxLength -= strlen(digits);
+	}
+
+	if (characters.size() > maxLength) {
+		characters.resize(maxLength);
+		// Don't leave half of a surrogate pair
+		if ((characters.back() & 0xfc00) == 0xd800)
+			characters.pop_back();
+	}
+	for (const char* digit = digits; *digit != '\0'; digit++)
+		characters.push_back(*digit);
+
+	return characters;
+}
+
+
+static bool
+compare_iso_names(const IsoNode* a, const IsoNode* b)
+{
+	// ECMA-119 9.3: by name, then extension, each padded with spaces. As
+	// all d-characters sort after the space, that's the same as comparing
+	// them as they are.
+	std::string baseA;
+	std::string extensionA;
+	std::string baseB;
+	std::string extensionB;
+	split_identifier(a->isoName, a->IsDirectory(), baseA, extensionA);
+	split_identifier(b->isoName, b->IsDirectory(), baseB, extensionB);
+
+	int result = baseA.compare(baseB);
+	if (result != 0)
+		return result < 0;
+	return extensionA < extensionB;
+}
+
+
+static bool
+compare_joliet_names(const IsoNode* a, const IsoNode* b)
+{
+	return a->jolietName < b->jolietName;
+}
+
+
+// Names that became the same get a number, all but the first one. They are
+// compared to the name before it was numbered.
+static void
+number_iso_names(std::vector<IsoNode*>& children)
+{
+	std::sort(children.begin(), children.end(), compare_iso_names);
+	std::set<std::string> used;
+	for (size_t i = 0; i < children.size(); i++)
+		used.insert(children[i]->isoName);
+	std::string previous;
+	for (size_t i = 0; i < children.size(); i++) {
+		if (i == 0 || children[i]->isoName != previous) {
+			previous = children[i]->isoName;
+			continue;
+		}
+
+		IsoNode* node = children[i];
+		std::string name;
+		for (int number = 1; used.count(name = mangle_iso_name(
+				node->isoName, node->IsDirectory(), number)) != 0;
+				number++) {
+		}
+		node->isoName = name;
+		used.insert(name);
+	}
+	std::sort(children.begin(), children.end(), compare_iso_names);
+}
+
+
+#pragma mark -- IsoNode --
+
+
+IsoNode::IsoNode(IsoNode* parent, const char* name)
+	:
+	parent(parent),
+	isoParent(parent),
+	relocated(NULL),
+	placeholder(NULL),
+	name(name),
+	hardLink(NULL),
+	extent(0),
+	directorySize(0),
+	continuationSize(0),
+	jolietExtent(0),
+	jolietSize(0),
+	directoryNumber(0),
+	jolietNumber(0)
+{
+	memset(&info, 0, sizeof(info));
+}
+
+
+IsoNode::~IsoNode()
+{
+	for (size_t i = 0; i < children.size(); i++)
+		delete children[i];
+}
+
+
+bool
+IsoNode::IsDirectory() const
+{
+	return S_ISDIR(info.st_mode);
+}
+
+
+bool
+IsoNode::IsFile() const
+{
+	return S_ISREG(info.st_mode);
+}
+
+
+bool
+IsoNode::IsSymlink() const
+{
+	return S_ISLNK(info.st_mode);
+}
+
+
+std::string
+IsoNode::Path(const char* root) const
+{
+	std::vector<const IsoNode*> nodes;
+	for (const IsoNode* node = this; node->parent != NULL;
+			node = node->parent)
+		nodes.push_back(node);
+
+	std::string path(root);
+	for (size_t i = nodes.size(); i-- > 0;) {
+		path += '/';
+		path += nodes[i]->name;
+	}
+	return path;
+}
+
+
+#pragma mark -- IsoTree --
+
+
+IsoTree::IsoTree()
+	:
+	fRoot(NULL),
+	fLock("iso tree"),
+	fWork(-1),
+	fPending(0),
+	fWorkers(0),
+	fStopped(0),
+	fFileCount(0),
+	fDirectoryCount(0),
+	fDataSize(0),
+	fStatus(B_OK)
+{
+}
+
+
+IsoTree::~IsoTree()
+{
+	delete fRoot;
+}
+
+
+status_t
+IsoTree::Scan(const char* path, int32 workers)
+{
+	delete fRoot;
+	fPath = path;
+	fRoot = new IsoNode(NULL, "");
+	fFileCount = 0;
+	fDirectoryCount = 1;
+	fDataSize = 0;
+	fStatus = B_OK;
+	fError.clear();
+	fWarnings.clear();
+
+	if (stat(path, &fRoot->info) != 0)
+		return errno;
+	if (!fRoot->IsDirectory())
+		return B_NOT_A_DIRECTORY;
+
+	if (workers <= 0) {
+		system_info info;
+		get_system_info(&info);
+		workers = max_c(info.cpu_count, 2);
+	}
+
+	fWork = create_sem(1, "iso tree work");
+	if (fWork < 0)
+		return fWork;
+
+	fQueue.assign(1, fRoot);
+	fPending = 1;
+	fWorkers = workers;
+
+	std::vector<thread_id> threads;
+	for (int32 i = 0; i < workers; i++) {
+		thread_id thread = spawn_thread(_Worker, "iso tree worker",
+			B_NORMAL_PRIORITY, this);
+		if (thread < 0)
+			break;
+		threads.push_back(thread);
+		resume_thread(thread);
+	}
+	if (threads.empty()) {
+		delete_sem(fWork);
+		return B_NO_MORE_THREADS;
+	}
+	// The workers there are get it all done as well
+	fWorkers = threads.size();
+
+	for (size_t i = 0; i < threads.size(); i++) {
+		status_t exitValue;
+		wait_for_thread(threads[i], &exitValue);
+	}
+	delete_sem(fWork);
+	fWork = -1;
+
+	if (fStatus != B_OK)
+		return fStatus;
+	if (atomic_get(&fStopped) != 0)
+		return B_CANCELED;
+
+	_MakeNames(fRoot);
+	// Before the hard links, they go by the order of the disc
+	_RelocateDeepFolders();
+	_FindHardLinks();
+	return B_OK;
+}
+
+
+void
+IsoTree::Stop()
+{
+	atomic_set(&fStopped, 1);
+}
+
+
+const char*
+IsoTree::Path() const
+{
+	return fPath.c_str();
+}
+
+
+IsoNode*
+IsoTree::Root() const
+{
+	return fRoot;
+}
+
+
+int64
+IsoTree::CountFiles() const
+{
+	return fFileCount;
+}
+
+
+int64
+IsoTree::CountDirectories() const
+{
+	return fDirectoryCount;
+}
+
+
+int64
+IsoTree::DataSize() const
+{
+	return fDataSize;
+}
+
+
+const char*
+IsoTree::Error() const
+{
+	return fError.c_str();
+}
+
+
+int32
+IsoTree::CountWarnings() const
+{
+	return (int32)fWarnings.size();
+}
+
+
+const char*
+IsoTree::WarningAt(int32 index) const
+{
+	return fWarnings[index].c_str();
+}
+
+
+#pragma mark -- Private Methods --
+
+
+int32
+IsoTree::_Worker(void* data)
+{
+	IsoTree* tree = (IsoTree*)data;
+
+	while (acquire_sem(tree->fWork) == B_OK) {
+		tree->fLock.Lock();
+		if (tree->fQueue.empty()) {
+			// All folders were read
+			tree->fLock.Unlock();
+			break;
+		}
+		IsoNode* directory = tree->fQueue.back();
+		tree->fQueue.pop_back();
+		tree->fLock.Unlock();
+
+		std::vector<IsoNode*> subdirectories;
+		status_t status = tree->_ReadDirectory(directory, subdirectories);
+		if (status != B_OK) {
+			// Like mkisofs, a folder that can't be read stays empty
+			std::string path = directory->Path(tree->fPath.c_str());
+			if (directory == tree->fRoot)
+				tree->_AddError(path, status);
+			else
+				tree->_AddWarning(path, status);
+			subdirectories.clear();
+		}
+		if (atomic_get(&tree->fStopped) != 0)
+			subdirectories.clear();
+
+		tree->fLock.Lock();
+		tree->fQueue.insert(tree->fQueue.end(), subdirectories.begin(),
+			subdirectories.end());
+		tree->fPending += (int32)subdirectories.size() - 1;
+		bool done = tree->fPending == 0;
+		tree->fLock.Unlock();
+
+		if (done) {
+			// Wake up all others, to let them quit
+			release_sem_etc(tree->fWork, tree->fWorkers, 0);
+		} else if (!subdirectories.empty())
+			release_sem_etc(tree->fWork, subdirectories.size(), 0);
+	}
+	return 0;
+}
+
+
+status_t
+IsoTree::_ReadDirectory(IsoNode* directory,
+	std::vector<IsoNode*>& subdirectories)
+{
+	if (atomic_get(&fStopped) != 0)
+		return B_OK;
+
+	std::string path = directory->Path(fPath.c_str());
+	int fd = open(path.c_str(), O_RDONLY | O_DIRECTORY);
+	if (fd < 0)
+		return errno;
+
+	DIR* dir = fdopendir(fd);
+	if (dir == NULL) {
+		status_t status = errno;
+		close(fd);
+		return status;
+	}
+
+	int64 files = 0;
+	while (dirent* entry = readdir(dir)) {
+		if (strcmp(entry->d_name, ".") == 0
+			|| strcmp(entry->d_name, "..") == 0)
+			continue;
+
+		IsoNode* node = new IsoNode(directory, entry->d_name);
+		if (fstatat(fd, entry->d_name, &node->info, AT_SYMLINK_NOFOLLOW)
+				!= 0) {
+			_AddWarning(path + "/" + entry->d_name, errno);
+			delete node;
+			continue;
+		}
+
+		if (node->IsSymlink()) {
+			char target[B_PATH_NAME_LENGTH];
+			ssize_t length = readlinkat(fd, entry->d_name, target,
+				sizeof(target));
+			if (length < 0) {
+				_AddWarning(path + "/" + entry->d_name, errno);
+				delete node;
+				continue;
+			}
+			node->linkTarget.assign(target, length);
+		} else if (node->IsDirectory())
+			subdirectories.push_back(node);
+		else if (node->IsFile())
+			files++;
+		else {
+			// Devices and the like have nothing to burn
+			delete node;
+			continue;
+		}
+		directory->children.push_back(node);
+	}
+	closedir(dir);
+
+	fLock.Lock();
+	fFileCount += files;
+	fDirectoryCount += subdirectories.size();
+	fLock.Unlock();
+
+	return B_OK;
+}
+
+
+void
+IsoTree::_AddError(const std::string& path, status_t error)
+{
+	fLock.Lock();
+	if (fStatus == B_OK) {
+		fStatus = error;
+		fError = path + ": " + strerror(error);
+	}
+	fLock.Unlock();
+
+	atomic_set(&fStopped, 1);
+}
+
+
+void
+IsoTree::_AddWarning(const std::string& path, status_t error)
+{
+	fLock.Lock();
+	fWarnings.push_back(path + ": " + strerror(error));
+	fLock.Unlock();
+}
+
+
+void
+IsoTree::_FindHardLinks()
+{
+	// The first one in the order of the disc keeps the contents
+	std::map<std::pair<dev_t, ino_t>, IsoNode*> files;
+	std::vector<IsoNode*> directories(1, fRoot);
+	fDataSize = 0;
+
+	for (size_t i = 0; i < directories.size(); i++) {
+		std::vector<IsoNode*>& children = directories[i]->children;
+		for (size_t j = 0; j < children.size(); j++) {
+			IsoNode* node = children[j];
+			if (node->IsDirectory()) {
+				directories.push_back(node);
+				continue;
+			}
+			if (!node->IsFile())
+				continue;
+
+			if (node->info.st_nlink > 1) {
+				std::pair<dev_t, ino_t> key(node->info.st_dev,
+					node->info.st_ino);
+				IsoNode*& first = files[key];
+				if (first != NULL) {
+					node->hardLink = first;
+					continue;
+				}
+				first = node;
+			}
+			fDataSize += node->info.st_size;
+		}
+	}
+}
+
+
+void
+IsoTree::_MakeNames(IsoNode* root)
+{
+	std::vector<IsoNode*> directories(1, root);
+	while (!directories.empty()) {
+		IsoNode* directory = directories.back();
+		directories.pop_back();
+
+		std::vector<IsoNode*>& children = directory->children;
+		for (size_t i = 0; i < children.size(); i++) {
+			IsoNode* node = children[i];
+			node->isoName = iso_name(node->name, node->IsDirectory());
+			node->jolietName = joliet_identifier(
+				joliet_characters(node->name, 0), node->IsDirectory());
+			if (node->IsDirectory())
+				directories.push_back(node);
+		}
+
+		number_iso_names(children);
+
+		directory->jolietChildren = children;
+		std::vector<IsoNode*>& joliet = directory->jolietChildren;
+		std::sort(joliet.begin(), joliet.end(), compare_joliet_names);
+		std::set<std::string> used;
+		for (size_t i = 0; i < joliet.size(); i++)
+			used.insert(joliet[i]->jolietName);
+		std::string previous;
+		for (size_t i = 0; i < joliet.size(); i++) {
+			if (i == 0 || joliet[i]->jolietName != previous) {
+				previous = joliet[i]->jolietName;
+				continue;
+			}
+
+			IsoNode* node = joliet[i];
+			std::string name;
+			for (int number = 1; used.count(name = joliet_identifier(
+					joliet_characters(node->name, number),
+					node->IsDirectory())) != 0; number++) {
+			}
+			node->jolietName = name;
+			used.insert(name);
+		}
+		std::sort(joliet.begin(), joliet.end(), compare_joliet_names);
+	}
+}
+
+
+void
+IsoTree::_RelocateDeepFolders()
+{
+	// Each folder with its level in the ISO 9660 tree
+	std::vector<std::pair<IsoNode*, int32> > directories;
+	directories.push_back(std::make_pair(fRoot, 1));
+	IsoNode* moved = NULL;
+
+	for (size_t i = 0; i < directories.size(); i++) {
+		IsoNode* directory = directories[i].first;
+		int32 level = directories[i].second + 1;
+
+		std::vector<IsoNode*>& children = directory->children;
+		for (size_t j = 0; j < children.size(); j++) {
+			IsoNode* node = children[j];
+			if (!node->IsDirectory())
+				continue;
+			if (level <= kMaxLevels) {
+				directories.push_back(std::make_pair(node, level));
+				continue;
+			}
+
+			if (moved == NULL) {
+				moved = new IsoNode(fRoot, "rr_moved");
+				moved->info = fRoot->info;
+				moved->isoName = iso_name(moved->name, true);
+			}
+
+			// It takes the place of the folder, as an empty file, but
+			// keeps its name
+			IsoNode* placeholder = new IsoNode(directory, node->name.c_str());
+			placeholder->info = node->info;
+			placeholder->info.st_mode = (node->info.st_mode & 0777) | S_IFREG;
+			placeholder->info.st_size = 0;
+			placeholder->info.st_nlink = 1;
+			placeholder->isoName = node->isoName;
+			placeholder->relocated = node;
+			children[j] = placeholder;
+
+			node->isoParent = moved;
+			node->placeholder = placeholder;
+			moved->children.push_back(node);
+			// Its folders are counted from "rr_moved" on
+			directories.push_back(std::make_pair(node, 3));
+		}
+	}
+	if (moved == NULL)
+		return;
+
+	// Folders of the same name may come from different places
+	number_iso_names(moved->children);
+
+	std::vector<IsoNode*>& children = fRoot->children;
+	children.insert(std::upper_bound(children.begin(), children.end(), moved,
+		compare_iso_names), moved);
+}
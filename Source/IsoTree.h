@@ -0,0 +1,126 @@
+/*
+ * Copyright 2026, BurnItNow Team. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _ISOTREE_H_
+#define _ISOTREE_H_
+
+
+#include <Locker.h>
+#include <OS.h>
+#include <SupportDefs.h>
+
+#include <sys/stat.h>
+
+#include <string>
+#include <vector>
+
+
+// A file, folder or symlink of an IsoTree
+struct IsoNode {
+	IsoNode*		parent;
+	// Where it is in the ISO 9660 tree. Only differs from "parent" for
+	// folders too deep for ISO 9660, which are moved to "rr_moved".
+	IsoNode*		isoParent;
+	// A moved folder leaves an empty file of its name behind, which Rock
+	// Ridge links to it. "relocated" of the file is the folder, and
+	// "placeholder" of the folder is the file.
+	IsoNode*		relocated;
+	IsoNode*		placeholder;
+	// Only for folders, in the order of the ISO 9660 directory
+	std::vector<IsoNode*> children;
+	// The same, in the order of the Joliet directory
+	std::vector<IsoNode*> jolietChildren;
+
+	std::string		name;		// as on the disk, UTF-8
+	std::string		isoName;	// d-characters, with ";1" for files
+	std::string		jolietName;	// UCS-2, big endian
+	std::string		linkTarget;	// of a symlink
+
+	struct stat		info;
+	// The file whose contents this one shares, when they are hard links
+	IsoNode*		hardLink;
+
+	// Set by IsoWriter. For files, where the contents start, for folders,
+	// where their ISO 9660 directory does.
+	uint32			extent;
+	uint32			directorySize;
+	// Rock Ridge entries that don't fit into the records of a directory
+	// follow right after it
+	uint32			continuationSize;
+	uint32			jolietExtent;
+	uint32			jolietSize;
+	uint16			directoryNumber;
+	uint16			jolietNumber;
+
+					IsoNode(IsoNode* parent, const char* name);
+					~IsoNode();
+
+	bool			IsDirectory() const;
+	bool			IsFile() const;
+	bool			IsSymlink() const;
+	// Its path, below "root"
+	std::string		Path(const char* root) const;
+};
+
+
+// Reads a folder with all its contents, with several threads, and gives
+// each file the names it gets on the disc. Only files, folders and symlinks
+// are taken, other nodes are left out. Hard links of a file are found, and
+// share its contents. Like mkisofs does, folders deeper than ISO 9660
+// allows are moved to "rr_moved" in its tree, but not in the Joliet one.
+class IsoTree {
+public:
+					IsoTree();
+					~IsoTree();
+
+	// Blocks until the whole folder was read. "workers" is the number of
+	// threads reading folders, by default one for each CPU.
+	status_t		Scan(const char* path, int32 workers = 0);
+	// Makes Scan() give up, from another thread
+	void			Stop();
+
+	const char*		Path() const;
+	IsoNode*		Root() const;
+
+	int64			CountFiles() const;
+	int64			CountDirectories() const;
+	// Of all files, hard links only count once
+	int64			DataSize() const;
+	// Why the scan failed, when the folder itself couldn't be read
+	const char*		Error() const;
+	// Files and folders inside it that couldn't be read, and were left out
+	int32			CountWarnings() const;
+	const char*		WarningAt(int32 index) const;
+
+private:
+	static int32	_Worker(void* data);
+
+	status_t		_ReadDirectory(IsoNode* directory,
+						std::vector<IsoNode*>& subdirectories);
+	void			_AddError(const std::string& path, status_t error);
+	void			_AddWarning(const std::string& path, status_t error);
+	void			_FindHardLinks();
+	void			_MakeNames(IsoNode* directory);
+	void			_RelocateDeepFolders();
+
+	std::string		fPath;
+	IsoNode*		fRoot;
+
+	BLocker			fLock;
+	sem_id			fWork;
+	std::vector<IsoNode*> fQueue;
+	int32			fPending;
+	int32			fWorkers;
+	int32			fStopped;
+
+	int64			fFileCount;
+	int64			fDirectoryCount;
+	int64			fDataSize;
+	status_t		fStatus;
+	std::string		fError;
+	std::vector<std::string> fWarnings;
+};
+
+
+#endif	// _ISOTREE_H_
@@ -0,0 +1,1554 @@
+/*
+ * Copyright 2026, BurnItNow Team. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "IsoWriter.h"
+
+#include <Catalog.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <new>
+
+
+#undef B_TRANSLATION_CONTEXT
+#define B_TRANSLATION_CONTEXT "IsoWriter"
+
+
+static const uint32 kSectorSize = 2048;
+static const uint32 kSystemAreaSectors = 16;
+// Like mkisofs, some drives can't read the last sectors of a track
+static const uint32 kPaddingSectors = 150;
+// The largest extent a directory record can describe, bigger files are
+// split into several ones (ISO 9660 level 3)
+static const uint32 kMaxExtentSize = 0xfffff800;
+static const size_t kBufferSize = 4 * 1024 * 1024;
+static const size_t kFillBufferSize = 1024 * 1024;
+static const int32 kMaxFillThreads = 4;
+static const bigtime_t kProgressInterval = 100000;
+
+static const uint8 kDirectoryFlag = 0x02;
+static const uint8 kMultiExtentFlag = 0x80;
+
+// Rock Ridge (RRIP 1.09) and SUSP
+static const uint8 kRockRidgePX = 0x01;
+static const uint8 kRockRidgeSL = 0x04;
+static const uint8 kRockRidgeNM = 0x08;
+static const uint8 kRockRidgeCL = 0x10;
+static const uint8 kRockRidgePL = 0x20;
+static const uint8 kRockRidgeRE = 0x40;
+static const uint8 kRockRidgeTF = 0x80;
+static const uint8 kContinueFlag = 0x01;
+static const uint8 kCurrentComponent = 0x02;
+static const uint8 kParentComponent = 0x04;
+static const uint8 kRootComponent = 0x08;
+static const size_t kContinuationEntrySize = 28;
+static const size_t kMaxEntrySize = 255;
+
+static const char* kSnapshotMagic = "BurnItNow image snapshot 1\n";
+static const size_t kMaxSnapshotPath = 65536;
+
+static const char* kExtensionIdentifier = "RRIP_1991A";
+static const char* kExtensionDescriptor = "THE ROCK RIDGE INTERCHANGE PROTOCOL "
+	"PROVIDES SUPPORT FOR POSIX FILE SYSTEM SEMANTICS";
+static const char* kExtensionSource = "PLEASE CONTACT DISC PUBLISHER FOR "
+	"SPECIFICATION SOURCE.  SEE PUBLISHER IDENTIFIER IN PRIMARY VOLUME "
+	"DESCRIPTOR FOR CONTACT INFORMATION.";
+
+
+// The continuation area of a directory, in which the Rock Ridge entries
+// that don't fit into a record go. Without data, it only counts.
+struct IsoWriter::Continuation {
+	uint32		start;
+	uint32		size;
+	uint8*		data;
+
+	Continuation(uint32 start, uint8* data)
+		:
+		start(start),
+		size(0),
+		data(data)
+	{
+	}
+
+	void Add(const std::string& entries, uint32& sector, uint32& offset)
+	{
+		// An area must not cross a sector
+		if (size % kSectorSize + entries.size() > kSectorSize)
+			size = (size + kSectorSize - 1) / kSectorSize * kSectorSize;
+
+		sector = start + size / kSectorSize;
+		offset = size % kSectorSize;
+		if (data != NULL)
+			memcpy(data + size, entries.data(), entries.size());
+		size += entries.size();
+	}
+};
+
+
+static uint32
+count_sectors(uint64 size)
+{
+	return (size + kSectorSize - 1) / kSectorSize;
+}
+
+
+static void
+set_le16(uint8* data, uint16 value)
+{
+	data[0] = value & 0xff;
+	data[1] = value >> 8;
+}
+
+
+static void
+set_be16(uint8* data, uint16 value)
+{
+	data[0] = value >> 8;
+	data[1] = value & 0xff;
+}
+
+
+static void
+set_le32(uint8* data, uint32 value)
+{
+	for (int i = 0; i < 4; i++)
+		data[i] = (value >> (8 * i)) & 0xff;
+}
+
+
+static void
+set_be32(uint8* data, uint32 value)
+{
+	for (int i = 0; i < 4; i++)
+		data[i] = (value >> (24 - 8 * i)) & 0xff;
+}
+
+
+// "Both byte orders", little endian followed by big endian
+static void
+set_both16(uint8* data, uint16 value)
+{
+	set_le16(data, value);
+	set_be16(data + 2, value);
+}
+
+
+static void
+set_both32(uint8* data, uint32 value)
+{
+	set_le32(data, value);
+	set_be32(data + 4, value);
+}
+
+
+static std::string
+both32(uint32 value)
+{
+	uint8 data[8];
+	set_both32(data, value);
+	return std::string((const char*)data, sizeof(data));
+}
+
+
+static void
+set_record_date(uint8* data, time_t time)
+{
+	struct tm date;
+	gmtime_r(&time, &date);
+	data[0] = date.tm_year;
+	data[1] = date.tm_mon + 1;
+	data[2] = date.tm_mday;
+	data[3] = date.tm_hour;
+	data[4] = date.tm_min;
+	data[5] = date.tm_sec;
+	data[6] = 0;
+}
+
+
+static void
+set_volume_date(uint8* data, time_t time)
+{
+	if (time == 0) {
+		// Not specified
+		memset(data, '0', 16);
+		data[16] = 0;
+		return;
+	}
+
+	struct tm date;
+	gmtime_r(&time, &date);
+	char digits[32];
+	snprintf(digits, sizeof(digits), "%04d%02d%02d%02d%02d%02d00",
+		(date.tm_year + 1900) % 10000, date.tm_mon + 1, date.tm_mday, date.tm_hour,
+		date.tm_min, date.tm_sec);
+	memcpy(data, digits, 16);
+	data[16] = 0;
+}
+
+
+// Fills a text field of a volume descriptor, padded with spaces. The
+// Joliet one has UCS-2 text, where "text" is copied as is.
+static void
+set_text(uint8* data, size_t size, const std::string& text, bool joliet)
+{
+	for (size_t i = 0; i < size; i++) {
+		if (joliet)
+			data[i] = i % 2 == 0 ? 0 : ' ';
+		else
+			data[i] = ' ';
+	}
+	memcpy(data, text.data(), std::min(text.size(), size));
+}
+
+
+static std::string
+ucs2_text(const char* text)
+{
+	std::string converted;
+	for (const char* c = text; *c != '\0'; c++) {
+		// Only ASCII is kept, like in the primary descriptor
+		uint8 character = *c;
+		if ((character & 0xc0) == 0x80)
+			continue;
+		converted += '\0';
+		converted += character < 0x80 ? character : '_';
+	}
+	return converted;
+}
+
+
+static std::string
+susp_entry(const char* signature, const std::string& data)
+{
+	std::string entry(signature, 2);
+	entry += (char)(data.size() + 4);
+	entry += '\1';
+	entry += data;
+	return entry;
+}
+
+
+static std::string
+rock_ridge_px(const struct stat& info)
+{
+	return susp_entry("PX", both32(info.st_mode) + both32(info.st_nlink)
+		+ both32(info.st_uid) + both32(info.st_gid));
+}
+
+
+static std::string
+rock_ridge_tf(const struct stat& info)
+{
+	// Modification, access and attribute change times
+	std::string data(1, 0x0e);
+	time_t times[] = { info.st_mtime, info.st_atime, info.st_ctime };
+	for (size_t i = 0; i < sizeof(times) / sizeof(times[0]); i++) {
+		uint8 date[7];
+		set_record_date(date, times[i]);
+		data.append((const char*)date, sizeof(date));
+	}
+	return susp_entry("TF", data);
+}
+
+
+static void
+add_rock_ridge_nm(std::vector<std::string>& entries, const std::string& name)
+{
+	const size_t maxPart = kMaxEntrySize - 5;
+	for (size_t i = 0; i < name.size() || i == 0; i += maxPart) {
+		bool last = i + maxPart >= name.size();
+		entries.push_back(susp_entry("NM",
+			std::string(1, last ? 0 : kContinueFlag)
+				+ name.substr(i, maxPart)));
+	}
+}
+
+
+static void
+add_rock_ridge_sl(std::vector<std::string>& entries, const std::string& target)
+{
+	// Each component record is flags, length and the name, a long name is
+	// split into several records
+	const size_t maxComponent = 200;
+	std::vector<std::string> components;
+	size_t start = 0;
+	if (!target.empty() && target[0] == '/') {
+		components.push_back(std::string(1, kRootComponent) + '\0');
+		start = 1;
+	}
+	while (start < target.size()) {
+		size_t end = target.find('/', start);
+		if (end == std::string::npos)
+			end = target.size();
+		std::string name = target.substr(start, end - start);
+		start = end + 1;
+
+		if (name.empty())
+			continue;
+		if (name == ".")
+			components.push_back(std::string(1, kCurrentComponent) + '\0');
+		else if (name == "..")
+			components.push_back(std::string(1, kParentComponent) + '\0');
+		else {
+			for (size_t i = 0; i < name.size(); i += maxComponent) {
+				bool last = i + maxComponent >= name.size();
+				std::string part = name.substr(i, maxComponent);
+				components.push_back(std::string(1, last ? 0 : kContinueFlag)
+					+ (char)part.size() + part);
+			}
+		}
+	}
+	if (components.empty())
+		components.push_back(std::string(2, '\0'));
+
+	// Entries that don't have the last component continue in the next one
+	const size_t maxData = kMaxEntrySize - 5;
+	std::string data;
+	for (size_t i = 0; i < components.size(); i++) {
+		if (data.size() + components[i].size() > maxData) {
+			entries.push_back(susp_entry("SL",
+				std::string(1, kContinueFlag) + data));
+			data.clear();
+		}
+		data += components[i];
+	}
+	entries.push_back(susp_entry("SL", std::string(1, '\0') + data));
+}
+
+
+// Adds a directory record, which must not cross a sector
+static void
+add_record(uint8* data, uint32& offset, const uint8* record, size_t length)
+{
+	if (offset % kSectorSize + length > kSectorSize)
+		offset = count_sectors(offset) * kSectorSize;
+	if (data != NULL)
+		memcpy(data + offset, record, length);
+	offset += length;
+}
+
+
+// Paths are written with their length first, so that they may contain
+// anything
+static void
+write_path(FILE* file, const std::string& path)
+{
+	fprintf(file, "%zu ", path.size());
+	fwrite(path.data(), 1, path.size(), file);
+	fputc('\n', file);
+}
+
+
+static bool
+read_path(FILE* file, std::string& path)
+{
+	size_t length;
+	if (fscanf(file, "%zu", &length) != 1 || length > kMaxSnapshotPath
+		|| fgetc(file) != ' ')
+		return false;
+
+	path.resize(length);
+	if (length > 0 && fread(&path[0], 1, length, file) != length)
+		return false;
+	return fgetc(file) == '\n';
+}
+
+
+static status_t
+write_all_at(int fd, const void* buffer, size_t size, off_t offset)
+{
+	const uint8* data = (const uint8*)buffer;
+	while (size > 0) {
+		ssize_t written = pwrite(fd, data, size, offset);
+		if (written < 0) {
+			if (errno == EINTR)
+				continue;
+			return errno;
+		}
+		data += written;
+		size -= written;
+		offset += written;
+	}
+	return B_OK;
+}
+
+
+static status_t
+write_all(int fd, const void* buffer, size_t size)
+{
+	const uint8* data = (const uint8*)buffer;
+	while (size > 0) {
+		ssize_t written = write(fd, data, size);
+		if (written < 0) {
+			if (errno == EINTR)
+				continue;
+			return errno;
+		}
+		data += written;
+		size -= written;
+	}
+	return B_OK;
+}
+
+
+IsoWriter::IsoWriter(BInvoker* invoker)
+	:
+	fInvoker(invoker),
+	fThread(-1),
+	fMeasureOnly(false),
+	fFillThreads(0),
+	fStopped(0),
+	fPathTableSize(0),
+	fPathTableSectors(0),
+	fJolietPathTableSize(0),
+	fJolietPathTableSectors(0),
+	fPathTable(0),
+	fJolietPathTable(0),
+	fDataStart(0),
+	fSectorCount(0),
+	fCreated(0),
+	fImageFD(-1),
+	fFillList(NULL),
+	fNextFile(0),
+	fRunningFillers(0),
+	fFillStatus(B_OK),
+	fBytesDone(0),
+	fBytesTotal(0),
+	fLastProgress(0)
+{
+}
+
+
+IsoWriter::~IsoWriter()
+{
+	Stop();
+	Wait();
+
+	delete fInvoker;
+}
+
+
+void
+IsoWriter::SetVolumeName(const char* name)
+{
+	fVolumeName = name;
+}
+
+
+void
+IsoWriter::SetFillThreads(int32 count)
+{
+	fFillThreads = count;
+}
+
+
+void
+IsoWriter::SetSnapshot(const char* path)
+{
+	fSnapshot = path;
+}
+
+
+status_t
+IsoWriter::Run(const char* folder, const char* image)
+{
+	if (fThread >= 0)
+		return B_BUSY;
+
+	fFolder = folder;
+	fImage = image;
+	fMeasureOnly = image == NULL;
+	atomic_set(&fStopped, 0);
+
+	fThread = spawn_thread(_Thread, "iso writer", B_NORMAL_PRIORITY, this);
+	if (fThread < 0) {
+		status_t status = fThread;
+		fThread = -1;
+		return status;
+	}
+	return resume_thread(fThread);
+}
+
+
+void
+IsoWriter::Stop()
+{
+	atomic_set(&fStopped, 1);
+	fTree.Stop();
+}
+
+
+status_t
+IsoWriter::Wait()
+{
+	if (fThread < 0)
+		return B_OK;
+
+	status_t status;
+	status_t result = wait_for_thread(fThread, &status);
+	fThread = -1;
+	return result == B_OK ? status : result;
+}
+
+
+status_t
+IsoWriter::Build(const char* folder, const char* image)
+{
+	if (fVolumeName.IsEmpty()) {
+		const char* leaf = strrchr(folder, '/');
+		fVolumeName = leaf != NULL && leaf[1] != '\0' ? leaf + 1 : folder;
+	}
+	fVolumeName.Truncate(32, false);
+
+	_Send(B_TRANSLATE("Reading the folder" B_UTF8_ELLIPSIS));
+	status_t status = fTree.Scan(folder);
+	if (status != B_OK) {
+		_Send(fTree.Error()[0] != '\0' ? fTree.Error() : strerror(status));
+		return status;
+	}
+	for (int32 i = 0; i < fTree.CountWarnings(); i++) {
+		BString warning(B_TRANSLATE("Left out %entry%"));
+		warning.ReplaceFirst("%entry%", fTree.WarningAt(i));
+		_Send(warning);
+	}
+
+	BString text(B_TRANSLATE("%files% files in %folders% folders"));
+	BString number;
+	number << fTree.CountFiles();
+	text.ReplaceFirst("%files%", number);
+	number.SetTo("");
+	number << fTree.CountDirectories();
+	text.ReplaceFirst("%folders%", number);
+	_Send(text);
+
+	status = _Layout();
+	if (status != B_OK)
+		return status;
+	if (atomic_get(&fStopped) != 0)
+		return B_CANCELED;
+	if (image == NULL)
+		return B_OK;
+
+	_FillMetadata();
+
+	std::vector<IsoNode*> changed;
+	bool update = !fSnapshot.IsEmpty()
+		&& _ReadSnapshot(image, changed) == B_OK;
+	// Whatever happens now, it won't describe the image anymore
+	if (!fSnapshot.IsEmpty())
+		unlink(fSnapshot);
+
+	if (update) {
+		text = B_TRANSLATE("The layout is the same as that of the last "
+			"image, updating the %changed% changed files" B_UTF8_ELLIPSIS);
+		number.SetTo("");
+		number << (int64)changed.size();
+		text.ReplaceFirst("%changed%", number);
+		_Send(text);
+
+		status = _UpdateImage(image, changed);
+	} else {
+		text = B_TRANSLATE("Writing %sectors% sectors" B_UTF8_ELLIPSIS);
+		number.SetTo("");
+		number << fSectorCount;
+		text.ReplaceFirst("%sectors%", number);
+		_Send(text);
+
+		status = _WriteImage(image);
+	}
+
+	if (status == B_OK && !fSnapshot.IsEmpty())
+		_WriteSnapshot(image);
+	if (status != B_OK && status != B_CANCELED)
+		_Send(strerror(status));
+	return status;
+}
+
+
+uint32
+IsoWriter::CountSectors() const
+{
+	return fSectorCount;
+}
+
+
+#pragma mark -- Private Methods --
+
+
+int32
+IsoWriter::_Thread(void* data)
+{
+	IsoWriter* writer = (IsoWriter*)data;
+	status_t status = writer->Build(writer->fFolder,
+		writer->fMeasureOnly ? NULL : writer->fImage.String());
+
+	if (writer->fInvoker != NULL) {
+		BMessage message(*writer->fInvoker->Message());
+		message.AddInt32("thread_exit", status);
+		if (status == B_OK)
+			message.AddInt64("sectors", writer->CountSectors());
+		writer->fInvoker->Invoke(&message);
+	}
+	return status;
+}
+
+
+int32
+IsoWriter::_Filler(void* data)
+{
+	IsoWriter* writer = (IsoWriter*)data;
+	// With room to fill up the last sector of a file
+	uint8* buffer = new(std::nothrow) uint8[kFillBufferSize + kSectorSize];
+	status_t status = buffer != NULL ? B_OK : B_NO_MEMORY;
+
+	// Takes the next file, until all are done or one of them failed
+	while (status == B_OK && atomic_get(&writer->fStopped) == 0
+		&& atomic_get(&writer->fFillStatus) == B_OK) {
+		int32 index = atomic_add(&writer->fNextFile, 1);
+		if (index >= (int32)writer->fFillList->size())
+			break;
+		status = writer->_FillExtent((*writer->fFillList)[index], buffer,
+			kFillBufferSize);
+	}
+	if (status != B_OK)
+		atomic_test_and_set(&writer->fFillStatus, status, B_OK);
+
+	delete[] buffer;
+	atomic_add(&writer->fRunningFillers, -1);
+	return status;
+}
+
+
+status_t
+IsoWriter::_Layout()
+{
+	IsoNode* root = fTree.Root();
+	fCreated = time(NULL);
+
+	// Both path tables want the folders breadth first, each level by
+	// parent and name, which is what reading the sorted children gives
+	fDirectories.assign(1, root);
+	for (size_t i = 0; i < fDirectories.size(); i++) {
+		std::vector<IsoNode*>& children = fDirectories[i]->children;
+		for (size_t j = 0; j < children.size(); j++) {
+			if (children[j]->IsDirectory())
+				fDirectories.push_back(children[j]);
+		}
+	}
+	fJolietDirectories.assign(1, root);
+	for (size_t i = 0; i < fJolietDirectories.size(); i++) {
+		std::vector<IsoNode*>& children = fJolietDirectories[i]->jolietChildren;
+		for (size_t j = 0; j < children.size(); j++) {
+			if (children[j]->IsDirectory())
+				fJolietDirectories.push_back(children[j]);
+		}
+	}
+
+	// Path tables refer to the parent by a 16 bit number. The Joliet one
+	// lacks "rr_moved", if there is one.
+	if (fDirectories.size() > 0xffff) {
+		_Send(B_TRANSLATE("Too many folders for an ISO 9660 image."));
+		return B_NOT_SUPPORTED;
+	}
+
+	fPathTableSize = 0;
+	for (size_t i = 0; i < fDirectories.size(); i++) {
+		fDirectories[i]->directoryNumber = i + 1;
+		size_t length = i == 0 ? 1 : fDirectories[i]->isoName.size();
+		fPathTableSize += 8 + length + length % 2;
+	}
+	fJolietPathTableSize = 0;
+	for (size_t i = 0; i < fJolietDirectories.size(); i++) {
+		fJolietDirectories[i]->jolietNumber = i + 1;
+		size_t length = i == 0 ? 1 : fJolietDirectories[i]->jolietName.size();
+		fJolietPathTableSize += 8 + length + length % 2;
+	}
+	fPathTableSectors = count_sectors(fPathTableSize);
+	fJolietPathTableSectors = count_sectors(fJolietPathTableSize);
+
+	// The primary and Joliet volume descriptors, and the terminator
+	uint32 sector = kSystemAreaSectors + 3;
+
+	// Little and big endian tables
+	fPathTable = sector;
+	sector += 2 * fPathTableSectors;
+	fJolietPathTable = sector;
+	sector += 2 * fJolietPathTableSectors;
+
+	// The size of the records doesn't depend on where things are, so the
+	// directories can be measured first
+	for (size_t i = 0; i < fDirectories.size(); i++) {
+		Continuation continuation(0, NULL);
+		fDirectories[i]->directorySize = _FillDirectory(NULL,
+			fDirectories[i], false, &continuation);
+		fDirectories[i]->continuationSize = continuation.size;
+	}
+	for (size_t i = 0; i < fJolietDirectories.size(); i++) {
+		fJolietDirectories[i]->jolietSize = _FillDirectory(NULL,
+			fJolietDirectories[i], true, NULL);
+	}
+
+	_LayOutDirectories(fDirectories, false, sector);
+	_LayOutDirectories(fJolietDirectories, true, sector);
+
+	fDataStart = sector;
+	_LayOutFiles(sector);
+
+	fSectorCount = sector + kPaddingSectors;
+	return B_OK;
+}
+
+
+void
+IsoWriter::_LayOutDirectories(std::vector<IsoNode*>& directories, bool joliet,
+	uint32& sector)
+{
+	for (size_t i = 0; i < directories.size(); i++) {
+		IsoNode* directory = directories[i];
+		if (joliet) {
+			directory->jolietExtent = sector;
+			sector += directory->jolietSize / kSectorSize;
+		} else {
+			directory->extent = sector;
+			sector += directory->directorySize / kSectorSize
+				+ count_sectors(directory->continuationSize);
+		}
+	}
+}
+
+
+void
+IsoWriter::_LayOutFiles(uint32& sector)
+{
+	// In the order of the directories, so that reading a folder from the
+	// disc doesn't have to seek much
+	fFiles.clear();
+	for (size_t i = 0; i < fDirectories.size(); i++) {
+		std::vector<IsoNode*>& children = fDirectories[i]->children;
+		for (size_t j = 0; j < children.size(); j++) {
+			IsoNode* node = children[j];
+			if (node->IsDirectory() || node->hardLink != NULL)
+				continue;
+
+			// Empty files and symlinks point to where the next file
+			// starts, but don't take any room
+			node->extent = sector;
+			if (!node->IsFile() || node->info.st_size == 0)
+				continue;
+
+			sector += count_sectors(node->info.st_size);
+			fFiles.push_back(node);
+		}
+	}
+
+	// The first of them comes before all its hard links
+	for (size_t i = 0; i < fDirectories.size(); i++) {
+		std::vector<IsoNode*>& children = fDirectories[i]->children;
+		for (size_t j = 0; j < children.size(); j++) {
+			if (children[j]->hardLink != NULL)
+				children[j]->extent = children[j]->hardLink->extent;
+		}
+	}
+}
+
+
+status_t
+IsoWriter::_WriteImage(const char* image)
+{
+	int fd = open(image, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+		return errno;
+
+	fBytesDone = 0;
+	fBytesTotal = (int64)fSectorCount * kSectorSize;
+	fLastProgress = 0;
+
+	int32 threads = _CountFillThreads(fFiles.size());
+	status_t status = threads > 1 ? _FillExtents(fd, threads)
+		: _CopyFiles(fd);
+	_SendProgress(true);
+
+	if (close(fd) != 0 && status == B_OK)
+		status = errno;
+
+	// Don't leave half an image behind
+	if (status != B_OK)
+		unlink(image);
+	return status;
+}
+
+
+status_t
+IsoWriter::_UpdateImage(const char* image,
+	const std::vector<IsoNode*>& changed)
+{
+	int fd = open(image, O_WRONLY);
+	if (fd < 0)
+		return errno;
+
+	// Only the metadata and the changed files are written
+	fBytesDone = 0;
+	fBytesTotal = fMetadata.size();
+	for (size_t i = 0; i < changed.size(); i++)
+		fBytesTotal += changed[i]->info.st_size;
+	fLastProgress = 0;
+
+	status_t status = write_all_at(fd, &fMetadata[0], fMetadata.size(),
+		(off_t)kSystemAreaSectors * kSectorSize);
+	atomic_add64(&fBytesDone, fMetadata.size());
+
+	if (status == B_OK && !changed.empty()) {
+		status = _FillFiles(fd, changed,
+			std::max(_CountFillThreads(changed.size()), (int32)1));
+	}
+	_SendProgress(true);
+
+	if (close(fd) != 0 && status == B_OK)
+		status = errno;
+
+	if (status != B_OK)
+		unlink(image);
+	return status;
+}
+
+
+int32
+IsoWriter::_CountFillThreads(size_t files) const
+{
+	int32 threads = fFillThreads;
+	if (threads <= 0) {
+		system_info info;
+		get_system_info(&info);
+		threads = std::min((int32)info.cpu_count, kMaxFillThreads);
+	}
+	return std::min(threads, (int32)files);
+}
+
+
+status_t
+IsoWriter::_CopyFiles(int fd)
+{
+	uint8* buffer = new(std::nothrow) uint8[kBufferSize];
+	if (buffer == NULL)
+		return B_NO_MEMORY;
+
+	memset(buffer, 0, kSystemAreaSectors * kSectorSize);
+	status_t status = write_all(fd, buffer, kSystemAreaSectors * kSectorSize);
+	if (status == B_OK)
+		status = write_all(fd, &fMetadata[0], fMetadata.size());
+	atomic_add64(&fBytesDone,
+		kSystemAreaSectors * kSectorSize + fMetadata.size());
+
+	size_t used = 0;
+	for (size_t i = 0; status == B_OK && i < fFiles.size(); i++) {
+		status = _WriteFile(fd, fFiles[i], buffer, used, kBufferSize);
+		if (status == B_OK && atomic_get(&fStopped) != 0)
+			status = B_CANCELED;
+	}
+
+	for (uint32 i = 0; status == B_OK && i < kPaddingSectors; i++) {
+		if (used == kBufferSize)
+			status = _Flush(fd, buffer, used);
+		memset(buffer + used, 0, kSectorSize);
+		used += kSectorSize;
+	}
+	if (status == B_OK)
+		status = _Flush(fd, buffer, used);
+
+	delete[] buffer;
+	return status;
+}
+
+
+status_t
+IsoWriter::_WriteFile(int fd, IsoNode* node, uint8* buffer, size_t& used,
+	size_t bufferSize)
+{
+	std::string path = node->Path(fTree.Path());
+	int file = open(path.c_str(), O_RDONLY);
+	if (file < 0) {
+		status_t status = errno;
+		_Send((path + ": " + strerror(status)).c_str());
+		return status;
+	}
+
+	// The file may have changed since it was read, it's cut or padded to
+	// the size that was laid out
+	off_t left = node->info.st_size;
+	bool shrunk = false;
+	status_t status = B_OK;
+	while (left > 0) {
+		if (used == bufferSize) {
+			status = _Flush(fd, buffer, used);
+			if (status != B_OK)
+				break;
+			if (atomic_get(&fStopped) != 0) {
+				status = B_CANCELED;
+				break;
+			}
+		}
+
+		size_t size = std::min((off_t)(bufferSize - used), left);
+		ssize_t bytesRead = 0;
+		if (!shrunk) {
+			bytesRead = read(file, buffer + used, size);
+			if (bytesRead < 0) {
+				if (errno == EINTR)
+					continue;
+				status = errno;
+				_Send((path + ": " + strerror(status)).c_str());
+				break;
+			}
+		}
+		if (bytesRead == 0) {
+			if (!shrunk) {
+				_SendShrunk(path);
+				shrunk = true;
+			}
+			memset(buffer + used, 0, size);
+			bytesRead = size;
+		}
+		used += bytesRead;
+		left -= bytesRead;
+	}
+	close(file);
+
+	if (status == B_OK) {
+		// Each file starts in a sector of its own. The buffer size is a
+		// multiple of it, so that always fits.
+		size_t padding = (kSectorSize - used % kSectorSize) % kSectorSize;
+		memset(buffer + used, 0, padding);
+		used += padding;
+	}
+	return status;
+}
+
+
+status_t
+IsoWriter::_Flush(int fd, uint8* buffer, size_t& used)
+{
+	status_t status = write_all(fd, buffer, used);
+	if (status != B_OK)
+		return status;
+
+	atomic_add64(&fBytesDone, used);
+	used = 0;
+	_SendProgress(false);
+	return B_OK;
+}
+
+
+status_t
+IsoWriter::_FillExtents(int fd, int32 threads)
+{
+	// BFS has no sparse files, this allocates the whole image at once, and
+	// leaves everything that isn't written zeroed: the system area, the
+	// padding, and the ends of the last sectors of the files
+	if (ftruncate(fd, fBytesTotal) != 0)
+		return errno;
+
+	status_t status = write_all_at(fd, &fMetadata[0], fMetadata.size(),
+		(off_t)kSystemAreaSectors * kSectorSize);
+	if (status != B_OK)
+		return status;
+
+	int64 contents = 0;
+	for (size_t i = 0; i < fFiles.size(); i++)
+		contents += fFiles[i]->info.st_size;
+	atomic_add64(&fBytesDone, fBytesTotal - contents);
+
+	return _FillFiles(fd, fFiles, threads);
+}
+
+
+status_t
+IsoWriter::_FillFiles(int fd, const std::vector<IsoNode*>& files,
+	int32 threads)
+{
+	fImageFD = fd;
+	fFillList = &files;
+	fNextFile = 0;
+	fFillStatus = B_OK;
+	fRunningFillers = 0;
+
+	std::vector<thread_id> fillers;
+	for (int32 i = 0; i < threads; i++) {
+		atomic_add(&fRunningFillers, 1);
+		thread_id thread = spawn_thread(_Filler, "iso extent filler",
+			B_NORMAL_PRIORITY, this);
+		if (thread < 0) {
+			atomic_add(&fRunningFillers, -1);
+			break;
+		}
+		fillers.push_back(thread);
+		resume_thread(thread);
+	}
+	if (fillers.empty())
+		return B_NO_MORE_THREADS;
+
+	while (atomic_get(&fRunningFillers) > 0) {
+		snooze(kProgressInterval);
+		_SendProgress(false);
+	}
+	for (size_t i = 0; i < fillers.size(); i++) {
+		status_t exitValue;
+		wait_for_thread(fillers[i], &exitValue);
+	}
+	fImageFD = -1;
+	fFillList = NULL;
+
+	if (atomic_get(&fStopped) != 0)
+		return B_CANCELED;
+	return fFillStatus;
+}
+
+
+status_t
+IsoWriter::_FillExtent(IsoNode* node, uint8* buffer, size_t bufferSize)
+{
+	std::string path = node->Path(fTree.Path());
+	int file = open(path.c_str(), O_RDONLY);
+	if (file < 0) {
+		status_t status = errno;
+		_Send((path + ": " + strerror(status)).c_str());
+		return status;
+	}
+
+	// Like _WriteFile(), only the size that was laid out is written, and
+	// what's missing is filled with zeros
+	off_t offset = (off_t)node->extent * kSectorSize;
+	off_t left = node->info.st_size;
+	bool shrunk = false;
+	status_t status = B_OK;
+	while (left > 0) {
+		if (atomic_get(&fStopped) != 0) {
+			status = B_CANCELED;
+			break;
+		}
+
+		size_t size = std::min((off_t)bufferSize, left);
+		ssize_t bytesRead = 0;
+		if (!shrunk) {
+			bytesRead = read(file, buffer, size);
+			if (bytesRead < 0) {
+				if (errno == EINTR)
+					continue;
+				status = errno;
+				_Send((path + ": " + strerror(status)).c_str());
+				break;
+			}
+		}
+		if (bytesRead == 0) {
+			if (!shrunk) {
+				_SendShrunk(path);
+				shrunk = true;
+			}
+			memset(buffer, 0, size);
+			bytesRead = size;
+		}
+
+		// The rest of the last sector is cleared as well, when an image is
+		// updated, the end of an older file may be there
+		size_t length = bytesRead;
+		if (left == bytesRead) {
+			length += (kSectorSize - (offset + length) % kSectorSize)
+				% kSectorSize;
+			memset(buffer + bytesRead, 0, length - bytesRead);
+		}
+
+		status = write_all_at(fImageFD, buffer, length, offset);
+		if (status != B_OK)
+			break;
+
+		offset += bytesRead;
+		left -= bytesRead;
+		atomic_add64(&fBytesDone, bytesRead);
+	}
+	close(file);
+	return status;
+}
+
+
+status_t
+IsoWriter::_ReadSnapshot(const char* image, std::vector<IsoNode*>& changed)
+{
+	FILE* file = fopen(fSnapshot, "r");
+	if (file == NULL)
+		return errno;
+
+	status_t status = _CompareSnapshot(file, image, changed);
+	fclose(file);
+	return status;
+}
+
+
+status_t
+IsoWriter::_CompareSnapshot(FILE* file, const char* image,
+	std::vector<IsoNode*>& changed)
+{
+	char magic[64];
+	if (fgets(magic, sizeof(magic), file) == NULL
+		|| strcmp(magic, kSnapshotMagic) != 0)
+		return B_BAD_DATA;
+
+	unsigned sectorCount;
+	unsigned dataStart;
+	size_t fileCount;
+	long long imageSize;
+	long long imageSeconds;
+	long long imageNanoseconds;
+	std::string folder;
+	if (fscanf(file, "%u %u %zu %lld %lld %lld", &sectorCount, &dataStart,
+			&fileCount, &imageSize, &imageSeconds, &imageNanoseconds) != 6
+		|| fgetc(file) != '\n' || !read_path(file, folder))
+		return B_BAD_DATA;
+
+	// The image must still be the one that was written
+	struct stat info;
+	if (stat(image, &info) != 0 || info.st_size != imageSize
+		|| info.st_mtim.tv_sec != imageSeconds
+		|| info.st_mtim.tv_nsec != imageNanoseconds)
+		return B_BAD_DATA;
+
+	if (folder != fTree.Path() || sectorCount != fSectorCount
+		|| dataStart != fDataStart || fileCount != fFiles.size())
+		return B_MISMATCHED_VALUES;
+
+	// Each file must be where it was before. Its contents only have to be
+	// written again if it changed.
+	for (size_t i = 0; i < fileCount; i++) {
+		unsigned extent;
+		long long size;
+		long long seconds;
+		long long nanoseconds;
+		long long inode;
+		std::string path;
+		if (fscanf(file, "%u %lld %lld %lld %lld", &extent, &size, &seconds,
+				&nanoseconds, &inode) != 5
+			|| fgetc(file) != ' ' || !read_path(file, path))
+			return B_BAD_DATA;
+
+		IsoNode* node = fFiles[i];
+		if (extent != node->extent || path != node->Path("")
+			|| count_sectors(size) != count_sectors(node->info.st_size))
+			return B_MISMATCHED_VALUES;
+
+		if (size != node->info.st_size
+			|| seconds != node->info.st_mtim.tv_sec
+			|| nanoseconds != node->info.st_mtim.tv_nsec
+			|| inode != (long long)node->info.st_ino)
+			changed.push_back(node);
+	}
+	return B_OK;
+}
+
+
+void
+IsoWriter::_WriteSnapshot(const char* image)
+{
+	struct stat info;
+	if (stat(image, &info) != 0)
+		return;
+
+	FILE* file = fopen(fSnapshot, "w");
+	if (file == NULL)
+		return;
+
+	fputs(kSnapshotMagic, file);
+	fprintf(file, "%u %u %zu %lld %lld %lld\n", (unsigned)fSectorCount,
+		(unsigned)fDataStart, fFiles.size(), (long long)info.st_size,
+		(long long)info.st_mtim.tv_sec, (long long)info.st_mtim.tv_nsec);
+	write_path(file, fTree.Path());
+
+	for (size_t i = 0; i < fFiles.size(); i++) {
+		IsoNode* node = fFiles[i];
+		fprintf(file, "%u %lld %lld %lld %lld ", (unsigned)node->extent,
+			(long long)node->info.st_size,
+			(long long)node->info.st_mtim.tv_sec,
+			(long long)node->info.st_mtim.tv_nsec,
+			(long long)node->info.st_ino);
+		write_path(file, node->Path(""));
+	}
+
+	// A broken one would only be ignored, but it's not left around either
+	bool failed = ferror(file) != 0;
+	if (fclose(file) != 0 || failed)
+		unlink(fSnapshot);
+}
+
+
+void
+IsoWriter::_FillMetadata()
+{
+	fMetadata.assign((size_t)(fDataStart - kSystemAreaSectors) * kSectorSize,
+		0);
+	// It starts with the first volume descriptor
+	auto sector = [this](uint32 number) {
+		return &fMetadata[(size_t)(number - kSystemAreaSectors)
+			* kSectorSize];
+	};
+
+	_FillVolumeDescriptor(sector(kSystemAreaSectors), false);
+	_FillVolumeDescriptor(sector(kSystemAreaSectors + 1), true);
+
+	uint8* terminator = sector(kSystemAreaSectors + 2);
+	terminator[0] = 255;
+	memcpy(terminator + 1, "CD001", 5);
+	terminator[6] = 1;
+
+	_FillPathTable(sector(fPathTable), false, false);
+	_FillPathTable(sector(fPathTable + fPathTableSectors), false, true);
+	_FillPathTable(sector(fJolietPathTable), true, false);
+	_FillPathTable(sector(fJolietPathTable + fJolietPathTableSectors), true,
+		true);
+
+	for (size_t i = 0; i < fDirectories.size(); i++) {
+		IsoNode* directory = fDirectories[i];
+		uint32 start = directory->extent
+			+ directory->directorySize / kSectorSize;
+		Continuation continuation(start, sector(start));
+		_FillDirectory(sector(directory->extent), directory, false,
+			&continuation);
+	}
+	for (size_t i = 0; i < fJolietDirectories.size(); i++) {
+		_FillDirectory(sector(fJolietDirectories[i]->jolietExtent),
+			fJolietDirectories[i], true, NULL);
+	}
+}
+
+
+void
+IsoWriter::_FillVolumeDescriptor(uint8* sector, bool joliet)
+{
+	IsoNode* root = fTree.Root();
+
+	sector[0] = joliet ? 2 : 1;
+	memcpy(sector + 1, "CD001", 5);
+	sector[6] = 1;
+
+	std::string volumeName = fVolumeName.String();
+	std::string application = "BURNITNOW";
+	if (joliet) {
+		volumeName = ucs2_text(fVolumeName);
+		application = ucs2_text(application.c_str());
+		// UCS-2 level 3
+		memcpy(sector + 88, "%/E", 3);
+	}
+
+	set_text(sector + 8, 32, "", joliet);
+	set_text(sector + 40, 32, volumeName, joliet);
+	set_both32(sector + 80, fSectorCount);
+	set_both16(sector + 120, 1);
+	set_both16(sector + 124, 1);
+	set_both16(sector + 128, kSectorSize);
+
+	if (joliet) {
+		set_both32(sector + 132, fJolietPathTableSize);
+		set_le32(sector + 140, fJolietPathTable);
+		set_be32(sector + 148, fJolietPathTable + fJolietPathTableSectors);
+		_FillRecord(sector + 156, root, std::string(1, '\0'),
+			root->jolietExtent, root->jolietSize, kDirectoryFlag, "");
+	} else {
+		set_both32(sector + 132, fPathTableSize);
+		set_le32(sector + 140, fPathTable);
+		set_be32(sector + 148, fPathTable + fPathTableSectors);
+		_FillRecord(sector + 156, root, std::string(1, '\0'), root->extent,
+			root->directorySize, kDirectoryFlag, "");
+	}
+
+	// Volume set, publisher, data preparer and application, then the
+	// copyright, abstract and bibliographic files
+	set_text(sector + 190, 128, "", joliet);
+	set_text(sector + 318, 128, "", joliet);
+	set_text(sector + 446, 128, "", joliet);
+	set_text(sector + 574, 128, application, joliet);
+	set_text(sector + 702, 37, "", joliet);
+	set_text(sector + 739, 37, "", joliet);
+	set_text(sector + 776, 37, "", joliet);
+
+	set_volume_date(sector + 813, fCreated);
+	set_volume_date(sector + 830, fCreated);
+	set_volume_date(sector + 847, 0);
+	set_volume_date(sector + 864, fCreated);
+	sector[881] = 1;
+}
+
+
+uint32
+IsoWriter::_FillPathTable(uint8* table, bool joliet, bool bigEndian)
+{
+	std::vector<IsoNode*>& directories
+		= joliet ? fJolietDirectories : fDirectories;
+
+	uint32 offset = 0;
+	for (size_t i = 0; i < directories.size(); i++) {
+		IsoNode* directory = directories[i];
+		std::string identifier(1, '\0');
+		if (i > 0)
+			identifier = joliet ? directory->jolietName : directory->isoName;
+
+		uint32 extent = joliet ? directory->jolietExtent : directory->extent;
+		IsoNode* parent = directory;
+		if (i > 0)
+			parent = joliet ? directory->parent : directory->isoParent;
+		uint16 parentNumber = joliet ? parent->jolietNumber
+			: parent->directoryNumber;
+
+		uint8* record = table + offset;
+		record[0] = identifier.size();
+		record[1] = 0;
+		if (bigEndian) {
+			set_be32(record + 2, extent);
+			set_be16(record + 6, parentNumber);
+		} else {
+			set_le32(record + 2, extent);
+			set_le16(record + 6, parentNumber);
+		}
+		memcpy(record + 8, identifier.data(), identifier.size());
+		offset += 8 + identifier.size() + identifier.size() % 2;
+	}
+	return offset;
+}
+
+
+uint32
+IsoWriter::_FillDirectory(uint8* data, IsoNode* directory, bool joliet,
+	Continuation* continuation)
+{
+	IsoNode* parent = joliet ? directory->parent : directory->isoParent;
+	if (parent == NULL)
+		parent = directory;
+	bool rockRidge = !joliet;
+
+	uint8 record[kMaxEntrySize + 1];
+	uint32 offset = 0;
+
+	const std::string dot(1, '\0');
+	const std::string dotDot(1, '\1');
+	std::string systemUse;
+	if (rockRidge) {
+		systemUse = _RockRidge(directory, NULL, directory->parent == NULL,
+			33 + dot.size(), continuation);
+	}
+	size_t length = _FillRecord(record, directory, dot,
+		joliet ? directory->jolietExtent : directory->extent,
+		joliet ? directory->jolietSize : directory->directorySize,
+		kDirectoryFlag, systemUse);
+	add_record(data, offset, record, length);
+
+	// A moved folder links back to where it came from
+	if (rockRidge) {
+		systemUse = _RockRidge(parent, NULL, false, 34, continuation,
+			directory->placeholder != NULL ? directory->parent : NULL);
+	}
+	length = _FillRecord(record, parent, dotDot,
+		joliet ? parent->jolietExtent : parent->extent,
+		joliet ? parent->jolietSize : parent->directorySize,
+		kDirectoryFlag, systemUse);
+	add_record(data, offset, record, length);
+
+	std::vector<IsoNode*>& children
+		= joliet ? directory->jolietChildren : directory->children;
+	for (size_t i = 0; i < children.size(); i++) {
+		IsoNode* node = children[i];
+		const std::string& identifier
+			= joliet ? node->jolietName : node->isoName;
+		if (rockRidge) {
+			systemUse = _RockRidge(node, node, false,
+				33 + identifier.size() + (identifier.size() + 1) % 2,
+				continuation);
+		}
+
+		if (node->IsDirectory()) {
+			length = _FillRecord(record, node, identifier,
+				joliet ? node->jolietExtent : node->extent,
+				joliet ? node->jolietSize : node->directorySize,
+				kDirectoryFlag, systemUse);
+			add_record(data, offset, record, length);
+			continue;
+		}
+
+		// Files too large for one extent get a record for each part
+		uint64 size = node->IsFile() ? node->info.st_size : 0;
+		uint32 extent = node->extent;
+		do {
+			uint32 partSize = std::min(size, (uint64)kMaxExtentSize);
+			size -= partSize;
+			length = _FillRecord(record, node, identifier, extent, partSize,
+				size > 0 ? kMultiExtentFlag : 0, systemUse);
+			add_record(data, offset, record, length);
+			extent += partSize / kSectorSize;
+		} while (size > 0);
+	}
+
+	// Directories fill whole sectors
+	return count_sectors(offset) * kSectorSize;
+}
+
+
+size_t
+IsoWriter::_FillRecord(uint8* record, const IsoNode* node,
+	const std::string& identifier, uint32 extent, uint32 size, uint8 flags,
+	const std::string& systemUse)
+{
+	size_t length = 33 + identifier.size();
+	length += length % 2;
+
+	memset(record, 0, length);
+	record[1] = 0;
+	set_both32(record + 2, extent);
+	set_both32(record + 10, size);
+	set_record_date(record + 18, node->info.st_mtime);
+	record[25] = flags;
+	set_both16(record + 28, 1);
+	record[32] = identifier.size();
+	memcpy(record + 33, identifier.data(), identifier.size());
+
+	memcpy(record + length, systemUse.data(), systemUse.size());
+	length += systemUse.size();
+	record[0] = length;
+	return length;
+}
+
+
+std::string
+IsoWriter::_RockRidge(const IsoNode* node, const IsoNode* named, bool root,
+	size_t recordSize, Continuation* continuation, const IsoNode* parentLink)
+{
+	// "node" has the attributes, "named" the name, if the record has one
+	std::vector<std::string> entries;
+	if (root) {
+		// Tells that SUSP is used, in the first record of the root
+		const char data[] = { '\xbe', '\xef', 0 };
+		entries.push_back(susp_entry("SP", std::string(data, sizeof(data))));
+	}
+
+	uint8 flags = kRockRidgePX | kRockRidgeTF;
+	if (named != NULL) {
+		flags |= kRockRidgeNM;
+		if (named->IsSymlink())
+			flags |= kRockRidgeSL;
+		// The file a folder left behind links to it, and the folder
+		// itself is hidden where it was moved to
+		if (named->relocated != NULL)
+			flags |= kRockRidgeCL;
+		if (named->placeholder != NULL)
+			flags |= kRockRidgeRE;
+	}
+	if (parentLink != NULL)
+		flags |= kRockRidgePL;
+	entries.push_back(susp_entry("RR", std::string(1, flags)));
+	entries.push_back(rock_ridge_px(node->info));
+	entries.push_back(rock_ridge_tf(node->info));
+	if (named != NULL) {
+		add_rock_ridge_nm(entries, named->name);
+		if (named->IsSymlink())
+			add_rock_ridge_sl(entries, named->linkTarget);
+		if (named->relocated != NULL)
+			entries.push_back(susp_entry("CL",
+				both32(named->relocated->extent)));
+		if (named->placeholder != NULL)
+			entries.push_back(susp_entry("RE", ""));
+	}
+	if (parentLink != NULL)
+		entries.push_back(susp_entry("PL", both32(parentLink->extent)));
+
+	std::vector<std::string> continued;
+	if (root) {
+		std::string data(1, strlen(kExtensionIdentifier));
+		data += (char)strlen(kExtensionDescriptor);
+		data += (char)strlen(kExtensionSource);
+		data += '\1';
+		data += kExtensionIdentifier;
+		data += kExtensionDescriptor;
+		data += kExtensionSource;
+		continued.push_back(susp_entry("ER", data));
+	}
+
+	// Records have an even length, and at most 255 bytes
+	size_t available = kMaxEntrySize - 1 - recordSize;
+	size_t total = 0;
+	for (size_t i = 0; i < entries.size(); i++)
+		total += entries[i].size();
+
+	std::string systemUse;
+	size_t i = 0;
+	if (total <= available && continued.empty()) {
+		for (; i < entries.size(); i++)
+			systemUse += entries[i];
+	} else {
+		for (; i < entries.size(); i++) {
+			if (systemUse.size() + entries[i].size()
+					+ kContinuationEntrySize > available)
+				break;
+			systemUse += entries[i];
+		}
+	}
+
+	if (i < entries.size() || !continued.empty()) {
+		std::string area;
+		for (; i < entries.size(); i++)
+			area += entries[i];
+		for (size_t j = 0; j < continued.size(); j++)
+			area += continued[j];
+
+		uint32 sector = 0;
+		uint32 offset = 0;
+		if (continuation != NULL)
+			continuation->Add(area, sector, offset);
+		systemUse += susp_entry("CE", both32(sector) + both32(offset)
+			+ both32(area.size()));
+	}
+
+	if (systemUse.size() % 2 != 0)
+		systemUse += '\0';
+	return systemUse;
+}
+
+
+void
+IsoWriter::_Send(const char* line)
+{
+	if (fInvoker == NULL)
+		return;
+
+	BMessage message(*fInvoker->Message());
+	message.AddString("line", line);
+	fInvoker->Invoke(&message);
+}
+
+
+void
+IsoWriter::_SendShrunk(const std::string& path)
+{
+	BString text(B_TRANSLATE("'%file%' got smaller while it was written, "
+		"the rest is filled with zeros."));
+	text.ReplaceFirst("%file%", path.c_str());
+	_Send(text);
+}
+
+
+void
+IsoWriter::_SendProgress(bool force)
+{
+	if (fInvoker == NULL)
+		return;
+
+	bigtime_t now = system_time();
+	if (!force && now - fLastProgress < kProgressInterval)
+		return;
+	fLastProgress = now;
+
+	BMessage message(*fInvoker->Message());
+	message.AddInt64("bytes_done", atomic_get64(&fBytesDone));
+	message.AddInt64("bytes_total", fBytesTotal);
+	fInvoker->Invoke(&message);
+}
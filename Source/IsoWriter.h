@@ -0,0 +1,157 @@
+/*
+ * Copyright 2026, BurnItNow Team. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _ISOWRITER_H_
+#define _ISOWRITER_H_
+
+
+#include "IsoTree.h"
+
+#include <Invoker.h>
+#include <OS.h>
+#include <String.h>
+
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+
+// Builds an ISO 9660 image of a folder, with Joliet and Rock Ridge names,
+// like "mkisofs -iso-level 3 -J -joliet-long -rock" does.
+//
+// The folder is read by IsoTree, and the whole layout is done before
+// anything is written: the directories and path tables in memory, and where
+// the contents of each file go. The contents are then filled in at their
+// place by several threads at once, or, with just one, written in large
+// sequential writes after the metadata.
+//
+// When a snapshot file is set, the layout of each image is kept in it. If
+// the next image of the same folder has the same layout, only its metadata
+// and the files that changed are written into the old image.
+//
+// While it runs, copies of the invoker's message are sent, like
+// CommandThread does: with "line" for what is being done, "bytes_done" and
+// "bytes_total" as it writes, and "thread_exit" with the status when it's
+// done, B_OK (0) if the image was written. Then "sectors" holds the size of
+// the image.
+class IsoWriter {
+public:
+					IsoWriter(BInvoker* invoker = NULL);
+	virtual			~IsoWriter();
+
+	void			SetVolumeName(const char* name);
+	// How many threads fill in the contents of the files, 0 for one per
+	// CPU, up to four. With one, the image is written sequentially.
+	void			SetFillThreads(int32 count);
+	// Where the layout of the image is kept, to update it the next time
+	void			SetSnapshot(const char* path);
+
+	// Run() fails with B_BUSY while an image is being written. The
+	// destructor stops it, and waits for it to quit. Without an "image",
+	// only the layout is done, to know its size.
+	status_t		Run(const char* folder, const char* image);
+	void			Stop();
+	status_t		Wait();
+
+	// Builds the image in the calling thread, or with a NULL "image", only
+	// lays it out
+	status_t		Build(const char* folder, const char* image);
+
+	// Known once the layout is done
+	uint32			CountSectors() const;
+
+private:
+	struct Continuation;
+
+	static int32	_Thread(void* data);
+	static int32	_Filler(void* data);
+
+	status_t		_Layout();
+	void			_LayOutDirectories(std::vector<IsoNode*>& directories,
+						bool joliet, uint32& sector);
+	void			_LayOutFiles(uint32& sector);
+	status_t		_WriteImage(const char* image);
+	status_t		_UpdateImage(const char* image,
+						const std::vector<IsoNode*>& changed);
+	int32			_CountFillThreads(size_t files) const;
+	status_t		_CopyFiles(int fd);
+	status_t		_WriteFile(int fd, IsoNode* node, uint8* buffer,
+						size_t& used, size_t bufferSize);
+	status_t		_Flush(int fd, uint8* buffer, size_t& used);
+	status_t		_FillExtents(int fd, int32 threads);
+	status_t		_FillFiles(int fd, const std::vector<IsoNode*>& files,
+						int32 threads);
+	status_t		_FillExtent(IsoNode* node, uint8* buffer,
+						size_t bufferSize);
+
+	status_t		_ReadSnapshot(const char* image,
+						std::vector<IsoNode*>& changed);
+	status_t		_CompareSnapshot(FILE* file, const char* image,
+						std::vector<IsoNode*>& changed);
+	void			_WriteSnapshot(const char* image);
+
+	void			_FillMetadata();
+	void			_FillVolumeDescriptor(uint8* sector, bool joliet);
+	uint32			_FillPathTable(uint8* table, bool joliet,
+						bool bigEndian);
+	uint32			_FillDirectory(uint8* data, IsoNode* directory,
+						bool joliet, Continuation* continuation);
+	size_t			_FillRecord(uint8* record, const IsoNode* node,
+						const std::string& identifier, uint32 extent,
+						uint32 size, uint8 flags,
+						const std::string& systemUse);
+	std::string		_RockRidge(const IsoNode* node, const IsoNode* named,
+						bool root, size_t recordSize,
+						Continuation* continuation,
+						const IsoNode* parentLink = NULL);
+
+	void			_Send(const char* line);
+	void			_SendShrunk(const std::string& path);
+	void			_SendProgress(bool force);
+
+	BInvoker*		fInvoker;
+	thread_id		fThread;
+	BString			fFolder;
+	BString			fImage;
+	BString			fVolumeName;
+	BString			fSnapshot;
+	bool			fMeasureOnly;
+	int32			fFillThreads;
+	int32			fStopped;
+
+	IsoTree			fTree;
+	// In the order of the path table, the root first
+	std::vector<IsoNode*> fDirectories;
+	std::vector<IsoNode*> fJolietDirectories;
+	// Files with contents of their own, in the order of the disc
+	std::vector<IsoNode*> fFiles;
+
+	uint32			fPathTableSize;
+	uint32			fPathTableSectors;
+	uint32			fJolietPathTableSize;
+	uint32			fJolietPathTableSectors;
+	uint32			fPathTable;
+	uint32			fJolietPathTable;
+	uint32			fDataStart;
+	uint32			fSectorCount;
+	time_t			fCreated;
+
+	// All sectors from the volume descriptors up to the file contents
+	std::vector<uint8> fMetadata;
+
+	// Shared by the fill threads
+	int				fImageFD;
+	const std::vector<IsoNode*>* fFillList;
+	int32			fNextFile;
+	int32			fRunningFillers;
+	int32			fFillStatus;
+
+	int64			fBytesDone;
+	int64			fBytesTotal;
+	bigtime_t		fLastProgress;
+};
+
+
+#endif	// _ISOWRITER_H_
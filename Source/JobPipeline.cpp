@@ -0,0 +1,286 @@
+/*
+ * Copyright 2026, BurnItNow Team. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "JobPipeline.h"
+
+#include "CommandThread.h"
+#include "Constants.h"
+
+
+JobStage::JobStage(const char* name, float weight, bigtime_t timeout)
+	:
+	fName(name),
+	fWeight(weight),
+	fTimeout(timeout)
+{
+}
+
+
+JobStage::~JobStage()
+{
+}
+
+
+const char*
+JobStage::Name() const
+{
+	return fName.String();
+}
+
+
+float
+JobStage::Weight() const
+{
+	return fWeight;
+}
+
+
+bigtime_t
+JobStage::Timeout() const
+{
+	return fTimeout;
+}
+
+
+float
+JobStage::ParseLine(const BString& line, int32 stream, BMessage& results)
+{
+	return -1.0f;
+}
+
+
+status_t
+JobStage::Finish(int32 exitCode, BMessage& results)
+{
+	return exitCode == 0 ? B_OK : B_ERROR;
+}
+
+
+#pragma mark -
+
+
+JobPipeline::JobPipeline(BInvoker* invoker)
+	:
+	BLooper("job pipeline"),
+	fStages(5, true),
+	fInvoker(invoker),
+	fThread(NULL),
+	fCurrent(-1),
+	fDoneWeight(0),
+	fTotalWeight(0),
+	fStageProgress(0),
+	fCanceled(false),
+	fStalled(false),
+	fFinished(false)
+{
+}
+
+
+JobPipeline::~JobPipeline()
+{
+	// Stops a command that's still running
+	delete fThread;
+	delete fInvoker;
+}
+
+
+void
+JobPipeline::AddStage(JobStage* stage)
+{
+	fStages.AddItem(stage);
+	fTotalWeight += stage->Weight();
+}
+
+
+status_t
+JobPipeline::Start()
+{
+	thread_id thread = Run();
+	if (thread < B_OK)
+		return thread;
+
+	return PostMessage(kPipelineStart);
+}
+
+
+void
+JobPipeline::Stop()
+{
+	PostMessage(kPipelineStop);
+}
+
+
+void
+JobPipeline::MessageReceived(BMessage* message)
+{
+	switch (message->what) {
+		case kPipelineStart:
+			_StartStage(0);
+			break;
+		case kPipelineStop:
+			fCanceled = true;
+			if (fThread != NULL && fThread->IsRunning())
+				fThread->Stop();
+			else if (!fFinished)
+				_Finish(B_CANCELED);
+			break;
+		case kStageOutput:
+			_StageOutput(message);
+			break;
+		default:
+			BLooper::MessageReceived(message);
+	}
+}
+
+
+#pragma mark -- Private Methods --
+
+
+void
+JobPipeline::_StartStage(int32 index)
+{
+	if (fFinished)
+		return;
+
+	fCurrent = index;
+	fStageProgress = 0;
+	fStalled = false;
+
+	if (fCanceled) {
+		_Finish(B_CANCELED);
+		return;
+	}
+
+	JobStage* stage = fStages.ItemAt(index);
+	if (stage == NULL) {
+		_Finish(B_OK);
+		return;
+	}
+
+	// The thread of the last stage has reported its exit already
+	delete fThread;
+	fThread = new CommandThread(NULL,
+		new BInvoker(new BMessage(kStageOutput), this));
+	fThread->SetTimeout(stage->Timeout());
+
+	status_t status = stage->Prepare(fThread, fResults);
+	if (status != B_OK) {
+		_Finish(status);
+		return;
+	}
+
+	BMessage start(fInvoker->Command());
+	start.AddInt32("stage_start", index);
+	start.AddString("stage_name", stage->Name());
+	start.AddFloat("progress", _Progress());
+	fInvoker->Invoke(&start);
+
+	status = fThread->Run();
+	if (status != B_OK)
+		_Finish(status);
+}
+
+
+void
+JobPipeline::_StageOutput(BMessage* message)
+{
+	JobStage* stage = fStages.ItemAt(fCurrent);
+	if (stage == NULL || fFinished)
+		return;
+
+	int32 code;
+	if (message->FindInt32("thread_exit", &code) == B_OK) {
+		_StageExit(message);
+		return;
+	}
+
+	BString line;
+	for (int32 i = 0; message->FindString("line", i, &line) == B_OK; i++) {
+		int32 stream = -1;
+		message->FindInt32("stream", i, &stream);
+
+		float progress = stage->ParseLine(line, stream, fResults);
+		if (progress >= 0)
+			fStageProgress = min_c(progress, 1.0f);
+	}
+
+	// Stopped only once, the notice comes again if quitting takes long
+	if (message->HasInt64("stalled") && !fStalled) {
+		fStalled = true;
+		fThread->Stop();
+	}
+
+	// Pass the lines (or a "stalled" notice) on as they are
+	BMessage output(*message);
+	output.what = fInvoker->Command();
+	output.AddInt32("stage", fCurrent);
+	output.AddFloat("progress", _Progress());
+	fInvoker->Invoke(&output);
+}
+
+
+void
+JobPipeline::_StageExit(BMessage* message)
+{
+	JobStage* stage = fStages.ItemAt(fCurrent);
+
+	int32 code = -1;
+	message->FindInt32("thread_exit", &code);
+
+	status_t status;
+	if (fStalled && !fCanceled) {
+		// It's up to the stage whether the pipeline can do without it
+		status = stage->Finish(code != 0 ? code : -1, fResults);
+		if (status != B_OK)
+			status = B_TIMED_OUT;
+	} else if (fCanceled || message->GetBool("canceled", false))
+		status = B_CANCELED;
+	else
+		status = stage->Finish(code, fResults);
+
+	if (status != B_OK) {
+		_Finish(status);
+		return;
+	}
+
+	fDoneWeight += stage->Weight();
+	fStageProgress = 0;
+
+	BMessage done(fInvoker->Command());
+	done.AddInt32("stage_done", fCurrent);
+	done.AddMessage("results", &fResults);
+	done.AddFloat("progress", _Progress());
+	fInvoker->Invoke(&done);
+
+	// The next stage starts right away, without a round trip to the window
+	_StartStage(fCurrent + 1);
+}
+
+
+void
+JobPipeline::_Finish(status_t status)
+{
+	fFinished = true;
+
+	BMessage exit(fInvoker->Command());
+	exit.AddInt32("pipeline_exit", status);
+	exit.AddInt32("stage", fCurrent);
+	exit.AddMessage("results", &fResults);
+	if (status == B_OK)
+		exit.AddFloat("progress", 1.0f);
+	fInvoker->Invoke(&exit);
+}
+
+
+float
+JobPipeline::_Progress() const
+{
+	if (fTotalWeight <= 0)
+		return 0;
+
+	JobStage* stage = fStages.ItemAt(fCurrent);
+	float current = stage != NULL ? stage->Weight() * fStageProgress : 0;
+	return (fDoneWeight + current) / fTotalWeight;
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2026, BurnItNow Team. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _JOBPIPELINE_H_
+#define _JOBPIPELINE_H_
+
+
+#include "ObjectList.h"
+
+#include <Invoker.h>
+#include <Looper.h>
+#include <Message.h>
+#include <String.h>
+
+
+class CommandThread;
+
+
+// One command of a JobPipeline
+class JobStage {
+public:
+					JobStage(const char* name, float weight = 1.0f,
+						bigtime_t timeout = B_INFINITE_TIMEOUT);
+	virtual			~JobStage();
+
+	const char*		Name() const;
+	// Share of the stage in the progress of the whole pipeline
+	float			Weight() const;
+	// Time the command may go without output before it counts as stalled.
+	// It's stopped then, and Finish() is called as if it had failed.
+	bigtime_t		Timeout() const;
+
+	// Adds the command to run to "thread". "results" holds what the stages
+	// before found out. An error fails the pipeline.
+	virtual	status_t Prepare(CommandThread* thread,
+						const BMessage& results) = 0;
+	// Called for each output line of the command. Returns the progress of
+	// the stage from 0 to 1, or a negative value if it didn't change.
+	virtual	float	ParseLine(const BString& line, int32 stream,
+						BMessage& results);
+	// Called after the command has quit. By default, the stage fails if
+	// the exit code isn't 0.
+	virtual	status_t Finish(int32 exitCode, BMessage& results);
+
+private:
+	BString			fName;
+	float			fWeight;
+	bigtime_t		fTimeout;
+};
+
+
+// Runs the commands of its stages one after the other in its own thread.
+// Results are passed from one stage to the next, and the first stage that
+// fails ends the pipeline.
+// Copies of the invoker's message are sent for the output of the stages,
+// with the "line", "stream" and "when" fields of CommandThread, plus the
+// "stage" index and the combined "progress" (0 to 1). Also sent are a
+// message with "stage_start" (the stage index) and "stage_name" before
+// each stage, one with "stage_done" and "results" after each, and one with
+// "pipeline_exit" (B_OK, B_CANCELED or the error), "stage" and "results"
+// at the end. A stage whose command stalled, and that fails because of it,
+// ends the pipeline with B_TIMED_OUT; its "stalled" notice is passed on.
+// To get rid of it, post it a B_QUIT_REQUESTED message.
+class JobPipeline : public BLooper {
+public:
+					JobPipeline(BInvoker* invoker);
+	virtual			~JobPipeline();
+
+	// Takes ownership of the stage. Stages can't be added after Start().
+	void			AddStage(JobStage* stage);
+
+	status_t		Start();
+	void			Stop();
+
+	virtual	void	MessageReceived(BMessage* message);
+
+private:
+	void			_StartStage(int32 index);
+	void			_StageOutput(BMessage* message);
+	void			_StageExit(BMessage* message);
+	void			_Finish(status_t status);
+	float			_Progress() const;
+
+	BObjectList<JobStage> fStages;
+	BInvoker*		fInvoker;
+	CommandThread*	fThread;
+	BMessage		fResults;
+
+	int32			fCurrent;
+	float			fDoneWeight;
+	float			fTotalWeight;
+	float			fStageProgress;
+	bool			fCanceled;
+	bool			fStalled;
+	bool			fFinished;
+};
+
+
+#endif	// _JOBPIPELINE_H_
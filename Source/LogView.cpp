@@ -0,0 +1,313 @@
+/*
+ * Copyright 2026, BurnItNow Team. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "LogView.h"
+
+#include <Clipboard.h>
+#include <ScrollBar.h>
+#include <Window.h>
+
+#include <math.h>
+#include <string.h>
+
+
+static const int32 kChunkLines = 1024;
+static const float kInset = 3.0f;
+
+
+LogView::LogView(const char* name, int32 maxLines)
+	:
+	BView(name, B_WILL_DRAW | B_FRAME_EVENTS | B_NAVIGABLE),
+	fLineCount(0),
+	fMaxLines(maxLines),
+	fMaxLength(0)
+{
+	SetFont(be_fixed_font);
+
+	font_height fontHeight;
+	GetFontHeight(&fontHeight);
+	fAscent = ceilf(fontHeight.ascent);
+	fLineHeight = ceilf(fontHeight.ascent + fontHeight.descent
+		+ fontHeight.leading);
+	fCharWidth = StringWidth("M");
+
+	SetViewColor(ui_color(B_DOCUMENT_BACKGROUND_COLOR));
+	SetLowColor(ViewColor());
+	SetHighColor(ui_color(B_DOCUMENT_TEXT_COLOR));
+}
+
+
+LogView::~LogView()
+{
+}
+
+
+void
+LogView::AttachedToWindow()
+{
+	_UpdateScrollBars();
+}
+
+
+void
+LogView::Draw(BRect updateRect)
+{
+	// Only the lines within "updateRect"
+	int32 first = (int32)((updateRect.top - kInset) / fLineHeight);
+	int32 last = (int32)((updateRect.bottom - kInset) / fLineHeight);
+	if (first < 0)
+		first = 0;
+	if (last >= fLineCount)
+		last = fLineCount - 1;
+
+	for (int32 i = first; i <= last; i++) {
+		const char* line;
+		int32 length;
+		_GetLine(i, &line, &length);
+		DrawString(line, length, BPoint(kInset, _LineTop(i) + fAscent));
+	}
+}
+
+
+void
+LogView::FrameResized(float width, float height)
+{
+	bool atEnd = _ScrolledToEnd();
+	_UpdateScrollBars();
+	if (atEnd)
+		_ScrollToEnd();
+}
+
+
+void
+LogView::MessageReceived(BMessage* message)
+{
+	switch (message->what) {
+		case B_COPY:
+		{
+			BString text;
+			for (int32 i = 0; i < fLineCount; i++) {
+				const char* line;
+				int32 length;
+				_GetLine(i, &line, &length);
+				text.Append(line, length);
+				text << "\n";
+			}
+
+			if (be_clipboard->Lock()) {
+				be_clipboard->Clear();
+				BMessage* clip = be_clipboard->Data();
+				clip->AddData("text/plain", B_MIME_TYPE, text.String(),
+					text.Length());
+				be_clipboard->Commit();
+				be_clipboard->Unlock();
+			}
+			break;
+		}
+		default:
+			BView::MessageReceived(message);
+			break;
+	}
+}
+
+
+void
+LogView::MouseDown(BPoint where)
+{
+	// To get B_COPY
+	MakeFocus(true);
+}
+
+
+#pragma mark -- Public Methods --
+
+
+void
+LogView::AddLine(const BString& line, bool replace)
+{
+	bool atEnd = _ScrolledToEnd();
+	_AddLine(line.String(), line.Length(), replace);
+	_DropChunks();
+	_UpdateScrollBars();
+	if (atEnd)
+		_ScrollToEnd();
+}
+
+
+void
+LogView::AddText(const char* text)
+{
+	bool atEnd = _ScrolledToEnd();
+	while (*text != '\0') {
+		const char* end = strchr(text, '\n');
+		if (end == NULL) {
+			_AddLine(text, strlen(text), false);
+			break;
+		}
+		_AddLine(text, end - text, false);
+		text = end + 1;
+	}
+	_DropChunks();
+	_UpdateScrollBars();
+	if (atEnd)
+		_ScrollToEnd();
+}
+
+
+void
+LogView::Clear()
+{
+	fChunks.clear();
+	fLineCount = 0;
+	fMaxLength = 0;
+
+	ScrollTo(0, 0);
+	_UpdateScrollBars();
+	Invalidate();
+}
+
+
+int32
+LogView::CountLines() const
+{
+	return fLineCount;
+}
+
+
+BString
+LogView::LastLine() const
+{
+	if (fLineCount == 0)
+		return BString();
+
+	const char* line;
+	int32 length;
+	_GetLine(fLineCount - 1, &line, &length);
+	return BString(line, length);
+}
+
+
+void
+LogView::SetMaxLines(int32 maxLines)
+{
+	fMaxLines = maxLines;
+	_DropChunks();
+	_UpdateScrollBars();
+}
+
+
+#pragma mark -- Private Methods --
+
+
+void
+LogView::_AddLine(const char* line, int32 length, bool replace)
+{
+	if (replace && fLineCount > 0) {
+		Chunk& chunk = fChunks.back();
+		chunk.text.resize(chunk.offsets.back());
+		chunk.offsets.pop_back();
+		fLineCount--;
+	}
+
+	if (fChunks.empty() || (int32)fChunks.back().offsets.size() == kChunkLines)
+		fChunks.emplace_back();
+
+	Chunk& chunk = fChunks.back();
+	chunk.offsets.push_back(chunk.text.size());
+	chunk.text.append(line, length);
+
+	if (length > fMaxLength)
+		fMaxLength = length;
+
+	Invalidate(BRect(0, _LineTop(fLineCount), Bounds().right,
+		_LineTop(fLineCount) + fLineHeight - 1));
+	fLineCount++;
+}
+
+
+void
+LogView::_DropChunks()
+{
+	// Only whole chunks, that keeps finding a line simple
+	int32 dropped = 0;
+	while (fChunks.size() > 1 && fLineCount - kChunkLines >= fMaxLines) {
+		fChunks.pop_front();
+		fLineCount -= kChunkLines;
+		dropped += kChunkLines;
+	}
+	if (dropped == 0)
+		return;
+
+	// What was shown moved up
+	BPoint scroll = Bounds().LeftTop();
+	ScrollTo(scroll.x, max_c(scroll.y - dropped * fLineHeight, 0));
+	Invalidate();
+}
+
+
+void
+LogView::_GetLine(int32 index, const char** _line, int32* _length) const
+{
+	// All chunks but the last have kChunkLines lines
+	const Chunk& chunk = fChunks[index / kChunkLines];
+	size_t line = index % kChunkLines;
+
+	int32 start = chunk.offsets[line];
+	int32 end = line + 1 < chunk.offsets.size()
+		? chunk.offsets[line + 1] : chunk.text.size();
+	*_line = chunk.text.data() + start;
+	*_length = end - start;
+}
+
+
+float
+LogView::_LineTop(int32 index) const
+{
+	return kInset + index * fLineHeight;
+}
+
+
+bool
+LogView::_ScrolledToEnd() const
+{
+	return Bounds().bottom >= _LineTop(fLineCount) + kInset - fLineHeight;
+}
+
+
+void
+LogView::_ScrollToEnd()
+{
+	float top = _LineTop(fLineCount) + kInset - Bounds().Height() - 1;
+	ScrollTo(Bounds().left, max_c(top, 0));
+}
+
+
+void
+LogView::_UpdateScrollBars()
+{
+	BRect bounds = Bounds();
+
+	BScrollBar* scrollBar = ScrollBar(B_VERTICAL);
+	if (scrollBar != NULL) {
+		float height = _LineTop(fLineCount) + kInset;
+		float range = max_c(height - bounds.Height() - 1, 0);
+		scrollBar->SetRange(0, range);
+		scrollBar->SetProportion(height > 0
+			? min_c(bounds.Height() / height, 1) : 1);
+		scrollBar->SetSteps(fLineHeight, max_c(bounds.Height() - fLineHeight,
+			fLineHeight));
+	}
+
+	scrollBar = ScrollBar(B_HORIZONTAL);
+	if (scrollBar != NULL) {
+		float width = fMaxLength * fCharWidth + 2 * kInset;
+		float range = max_c(width - bounds.Width() - 1, 0);
+		scrollBar->SetRange(0, range);
+		scrollBar->SetProportion(width > 0
+			? min_c(bounds.Width() / width, 1) : 1);
+		scrollBar->SetSteps(fCharWidth, max_c(bounds.Width() - fCharWidth,
+			fCharWidth));
+	}
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright 2026, BurnItNow Team. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _LOGVIEW_H_
+#define _LOGVIEW_H_
+
+
+#include <String.h>
+#include <View.h>
+
+#include <deque>
+#include <string>
+#include <vector>
+
+
+// Shows the output of the command line tools. Only the visible lines are
+// drawn, and adding a line or replacing the last one doesn't depend on how
+// many there are. The lines are kept in chunks, when there are more than
+// "maxLines", the oldest chunk is dropped.
+// It uses the fixed font, so the width of a line comes from its length.
+// Copy puts the whole output on the clipboard.
+class LogView : public BView {
+public:
+					LogView(const char* name, int32 maxLines = 100000);
+	virtual			~LogView();
+
+	virtual void	AttachedToWindow();
+	virtual void	Draw(BRect updateRect);
+	virtual void	FrameResized(float width, float height);
+	virtual void	MessageReceived(BMessage* message);
+	virtual void	MouseDown(BPoint where);
+
+	// Adds "line" at the end, in place of the last line if "replace" is set.
+	// Stays at the end if it was scrolled there.
+	void			AddLine(const BString& line, bool replace = false);
+	// Adds every line of "text"
+	void			AddText(const char* text);
+	void			Clear();
+
+	int32			CountLines() const;
+	BString			LastLine() const;
+	void			SetMaxLines(int32 maxLines);
+
+private:
+	struct Chunk {
+		std::string			text;
+		// Where each line starts in "text"
+		std::vector<int32>	offsets;
+	};
+
+	void			_AddLine(const char* line, int32 length, bool replace);
+	void			_DropChunks();
+	void			_GetLine(int32 index, const char** _line,
+						int32* _length) const;
+	float			_LineTop(int32 index) const;
+	bool			_ScrolledToEnd() const;
+	void			_ScrollToEnd();
+	void			_UpdateScrollBars();
+
+	std::deque<Chunk> fChunks;
+	int32			fLineCount;
+	int32			fMaxLines;
+	int32			fMaxLength;
+
+	float			fLineHeight;
+	float			fAscent;
+	float			fCharWidth;
+};
+
+
+#endif	// _LOGVIEW_H_
@@ -0,0 +1,222 @@
+/*
+ * Copyright 2026, BurnItNow Team. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "MultiBurner.h"
+
+#include "CommandThread.h"
+#include "Constants.h"
+
+#include <Catalog.h>
+
+#undef B_TRANSLATION_CONTEXT
+#define B_TRANSLATION_CONTEXT "MultiBurner"
+
+
+MultiBurner::MultiBurner(BHandler* target, uint32 what)
+	:
+	fDrives(MAX_DEVICES, true),
+	fTarget(target),
+	fWhat(what)
+{
+}
+
+
+MultiBurner::~MultiBurner()
+{
+	for (int32 i = 0; i < fDrives.CountItems(); i++) {
+		Drive* drive = fDrives.ItemAt(i);
+		// Stops a command that's still running
+		delete drive->thread;
+		delete drive->parser;
+	}
+}
+
+
+void
+MultiBurner::AddDrive(const sdevice& device, const BStringList& arguments,
+	const char* image)
+{
+	Drive* drive = new Drive;
+	drive->device = device;
+	drive->progress = 0;
+	drive->eta = "--";
+	drive->parser = new OutputParser(drive->progress, drive->eta);
+	drive->abort = 0;
+	drive->exitCode = -1;
+	drive->done = false;
+
+	BMessage* message = new BMessage(fWhat);
+	message->AddInt32("drive", fDrives.CountItems());
+	drive->thread = new CommandThread(NULL, new BInvoker(message, fTarget));
+	drive->thread->SetSeparateStreams(true);
+	drive->thread->SetTimeout(kCdrecordTimeout);
+
+	for (int32 i = 0; i < arguments.CountStrings(); i++)
+		drive->thread->AddArgument(arguments.StringAt(i));
+
+	BString dev("dev=");
+	dev.Append(device.number);
+	drive->thread->AddArgument(dev)
+		->AddArgument(image);
+
+	fDrives.AddItem(drive);
+}
+
+
+int32
+MultiBurner::CountDrives() const
+{
+	return fDrives.CountItems();
+}
+
+
+status_t
+MultiBurner::Run()
+{
+	// Start all of them right after each other, so they keep reading about
+	// the same part of the image
+	status_t status = B_ERROR;
+	int32 started = 0;
+	for (int32 i = 0; i < fDrives.CountItems(); i++) {
+		Drive* drive = fDrives.ItemAt(i);
+		status_t result = drive->thread->Run();
+		if (result != B_OK) {
+			// Its exit is never reported
+			drive->done = true;
+			status = result;
+		} else
+			started++;
+	}
+	return started > 0 ? B_OK : status;
+}
+
+
+void
+MultiBurner::Stop()
+{
+	for (int32 i = 0; i < fDrives.CountItems(); i++)
+		fDrives.ItemAt(i)->thread->Stop();
+}
+
+
+bool
+MultiBurner::ParseOutput(BMessage* message, BString& output)
+{
+	int32 index = -1;
+	message->FindInt32("drive", &index);
+	Drive* drive = fDrives.ItemAt(index);
+	if (drive == NULL)
+		return false;
+
+	BString line;
+	for (int32 i = 0; message->FindString("line", i, &line) == B_OK; i++) {
+		int32 stream = -1;
+		message->FindInt32("stream", i, &stream);
+
+		// The progress of all drives is shown in Status(), not in the output
+		ParseEvent event = drive->parser->ParseCdrecordLine(line, stream);
+		if (event.result < 0)
+			drive->abort = event.result;
+		if (event.result <= 0)
+			output << "[" << drive->device.number << "] " << line << "\n";
+	}
+
+	// Only this drive is stopped, the others go on
+	if (message->HasInt64("stalled") && drive->abort != STALLED) {
+		drive->abort = STALLED;
+		drive->thread->Stop();
+		output << "[" << drive->device.number << "] "
+			<< B_TRANSLATE_COMMENT("The burner stopped responding.",
+				"Burn output") << "\n";
+	}
+
+	int32 code;
+	if (message->FindInt32("thread_exit", &code) == B_OK) {
+		drive->exitCode = code;
+		drive->done = true;
+	}
+
+	for (int32 i = 0; i < fDrives.CountItems(); i++) {
+		if (!fDrives.ItemAt(i)->done)
+			return false;
+	}
+	return true;
+}
+
+
+BString
+MultiBurner::Status() const
+{
+	BString status;
+	for (int32 i = 0; i < fDrives.CountItems(); i++) {
+		Drive* drive = fDrives.ItemAt(i);
+		if (i > 0)
+			status << "   ";
+
+		BString state;
+		if (!drive->done)
+			state.SetToFormat("%d%%", (int)(drive->progress * 100));
+		else if (drive->exitCode == 0)
+			state = B_TRANSLATE_COMMENT("done", "Burn state of a drive");
+		else if (drive->abort == STALLED)
+			state = B_TRANSLATE_COMMENT("stalled", "Burn state of a drive");
+		else
+			state = B_TRANSLATE_COMMENT("failed", "Burn state of a drive");
+
+		status << drive->device.number << ": " << state;
+	}
+	return status;
+}
+
+
+float
+MultiBurner::Progress() const
+{
+	float progress = 1.0f;
+	for (int32 i = 0; i < fDrives.CountItems(); i++) {
+		Drive* drive = fDrives.ItemAt(i);
+		if (!drive->done && drive->progress < progress)
+			progress = drive->progress;
+	}
+	return progress;
+}
+
+
+const char*
+MultiBurner::ETA() const
+{
+	// The slowest drive decides when all are done
+	Drive* slowest = NULL;
+	for (int32 i = 0; i < fDrives.CountItems(); i++) {
+		Drive* drive = fDrives.ItemAt(i);
+		if (!drive->done
+			&& (slowest == NULL || drive->progress < slowest->progress))
+			slowest = drive;
+	}
+	return slowest != NULL ? slowest->eta.String() : "";
+}
+
+
+int32
+MultiBurner::CountFailed() const
+{
+	int32 failed = 0;
+	for (int32 i = 0; i < fDrives.CountItems(); i++) {
+		if (fDrives.ItemAt(i)->exitCode != 0)
+			failed++;
+	}
+	return failed;
+}
+
+
+bool
+MultiBurner::DiscTooSmall() const
+{
+	for (int32 i = 0; i < fDrives.CountItems(); i++) {
+		if (fDrives.ItemAt(i)->abort == SMALLDISC)
+			return true;
+	}
+	return false;
+}
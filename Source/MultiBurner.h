@@ -0,0 +1,75 @@
+/*
+ * Copyright 2026, BurnItNow Team. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _MULTIBURNER_H_
+#define _MULTIBURNER_H_
+
+
+#include "BurnWindow.h"
+#include "ObjectList.h"
+#include "OutputParser.h"
+
+#include <Handler.h>
+#include <Message.h>
+#include <String.h>
+#include <StringList.h>
+
+
+class CommandThread;
+
+
+// Burns the same image on several drives at once, with one cdrecord for
+// each. They all read the image at about the same pace, so it only has to
+// come from the disk once, the others get it from the file cache.
+// The messages of the commands are sent to "target" like those of a single
+// CommandThread, with the index of the drive added as "drive".
+class MultiBurner {
+public:
+					MultiBurner(BHandler* target, uint32 what);
+					~MultiBurner();
+
+	// "arguments" is the cdrecord command line without the device and the
+	// image, those are added here.
+	void			AddDrive(const sdevice& device,
+						const BStringList& arguments, const char* image);
+	int32			CountDrives() const;
+
+	// Fails when none of the commands could be started. Then there are no
+	// messages to wait for, all drives are done.
+	status_t		Run();
+	void			Stop();
+
+	// Parses a message of one of the commands. The lines that aren't
+	// progress are added to "output", tagged with the drive they came from.
+	// Returns true once all commands have quit.
+	bool			ParseOutput(BMessage* message, BString& output);
+
+	// The progress of each drive, as shown to the user
+	BString			Status() const;
+	// The progress of the slowest drive, from 0 to 1
+	float			Progress() const;
+	const char*		ETA() const;
+
+	int32			CountFailed() const;
+	bool			DiscTooSmall() const;
+
+private:
+	struct Drive {
+		sdevice			device;
+		CommandThread*	thread;
+		float			progress;
+		BString			eta;
+		OutputParser*	parser;
+		int32			abort;
+		int32			exitCode;
+		bool			done;
+	};
+
+	BObjectList<Drive> fDrives;
+	BHandler*		fTarget;
+	uint32			fWhat;
+};
+
+
+#endif	// _MULTIBURNER_H_
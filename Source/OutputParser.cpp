@@ -5,26 +5,187 @@
  * Author:
  *	Humdinger, humdingerb@gmail.com
  */
-#include <parsedate.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
+
+#include <charconv>
+#include <string_view>
 
 #include <Catalog.h>
-#include <DateTimeFormat.h>
 #include <DurationFormat.h>
-#include <StringList.h>
-#include <TimeFormat.h>
 
 #include "Constants.h"
 #include "OutputParser.h"
+#include "PatternMatcher.h"
 
 #undef B_TRANSLATION_CONTEXT
 #define B_TRANSLATION_CONTEXT "Parser"
 
 
+// The messages looked for in the output of each tool. Every line is matched
+// against all messages of its tool at once, see PatternMatcher.
+enum {
+	kCdrecordMayNotFit = 0,
+	kCdrecordNotFit,
+	kCdrecordBadAudio,
+	kCdrecordProgress,
+	kCdrecordFifoStats,
+	kCdrecordBufferStats,
+	kCdrecordUnderruns
+};
+
+static const char* const kCdrecordPatterns[] = {
+	"cdrecord: WARNING: Data may not fit on current disk.",
+	"cdrecord: Data does not fit on current disk.",
+	"cdrecord: Inappropriate audio coding in",
+	" MB written (fifo",
+	"fifo was ",
+	"Min drive buffer fill was ",
+	" possible drive buffer underruns predicted"
+};
+
+enum {
+	kMediainfoRemaining = 0,
+	kMediainfoLeadout
+};
+
+static const char* const kMediainfoPatterns[] = {
+	"Remaining writable size:",
+	"Last session leadout start address:"
+};
+
+enum {
+	kMkisofsProgress = 0
+};
+
+static const char* const kMkisofsPatterns[] = {
+	"done, estimate finish"
+};
+
+enum {
+	kReadcdCapacity = 0,
+	kReadcdProgress
+};
+
+static const char* const kReadcdPatterns[] = {
+	"Capacity: ",
+	"addr:"
+};
+
+// A fifo that drained over this many progress lines in a row, and is below
+// kLowFifoFill, is worth a warning. Below kCriticalFifoFill it always is.
+static const int32 kDrainLines = 8;
+static const int32 kLowFifoFill = 50;
+static const int32 kCriticalFifoFill = 10;
+// At the end the fifo runs empty anyway, it's only watched while there's
+// more than this left to write. cdrecord's fifo is 4 MiB unless fs= is used.
+static const int64 kFifoTail = 64 * 1024 * 1024;
+
+#define FOUND(found, pattern) (((found) & (1UL << (pattern))) != 0)
+
+
+// Returns field "index" of "line", like BString::Split() with "noEmpty" would,
+// but without copying anything
+static std::string_view
+field_at(std::string_view line, int32 index, char separator = ' ')
+{
+	size_t start = 0;
+	while (true) {
+		start = line.find_first_not_of(separator, start);
+		if (start == std::string_view::npos)
+			return std::string_view();
+
+		size_t end = line.find(separator, start);
+		if (index-- == 0)
+			return line.substr(start, end - start);
+		if (end == std::string_view::npos)
+			return std::string_view();
+		start = end;
+	}
+}
+
+
+// Parses the number at the start of "field" in place. Like atof() and
+// atoll(), leading spaces are skipped, and 0 is returned if there's no
+// number.
+template<typename Number>
+static Number
+parse_number(std::string_view field)
+{
+	size_t start = field.find_first_not_of(' ');
+	if (start == std::string_view::npos)
+		return 0;
+
+	Number number = 0;
+	std::from_chars(field.data() + start, field.data() + field.size(),
+		number);
+	return number;
+}
+
+
+static std::string_view
+view(const BString& string)
+{
+	return std::string_view(string.String(), string.Length());
+}
+
+
+// Returns the number that follows "label" in "line", or -1 if there's none
+static int32
+number_after(std::string_view line, std::string_view label)
+{
+	size_t offset = line.find(label);
+	if (offset == std::string_view::npos)
+		return -1;
+
+	std::string_view rest = line.substr(offset + label.size());
+	size_t start = rest.find_first_not_of(' ');
+	if (start == std::string_view::npos)
+		return -1;
+
+	int32 number = -1;
+	std::from_chars(rest.data() + start, rest.data() + rest.size(), number);
+	return number;
+}
+
+
+ParseEvent::ParseEvent()
+	:
+	result(NOCHANGE),
+	replaceLine(false),
+	progress(-1),
+	bytesDone(-1),
+	bytesTotal(-1),
+	speed(-1),
+	averageSpeed(-1),
+	fifoFill(-1),
+	bufferFill(-1),
+	timeLeft(-1),
+	fifoWarning(false)
+{
+}
+
+
+BufferStats::BufferStats()
+	:
+	fifoFill(-1),
+	bufferFill(-1),
+	minFifoFill(-1),
+	minBufferFill(-1),
+	fifoEmpty(-1),
+	underruns(-1),
+	fifoLow(false)
+{
+}
+
+
 OutputParser::OutputParser(float& noteProgress, BString& noteEta):
 	progress(noteProgress),
-	eta(noteEta)
+	eta(noteEta),
+	fCapacity(0),
+	fFinishedIn(B_TRANSLATE("Finished in %duration%")),
+	fFinishedSoon(B_TRANSLATE("Finished very soon now"))
 {
 	Reset();
 }
@@ -38,224 +199,330 @@ OutputParser::~OutputParser()
 #pragma mark -- Public Methods --
 
 
-int32
-OutputParser::ParseBlankLine(BString& text, BString newline)
+ParseEvent
+OutputParser::ParseBlankLine(const BString& newline)
 {
-	return NOCHANGE;
+	return _Event(NOCHANGE);
 }
 
 
-int32
-OutputParser::ParseCdrecordLine(BString& text, BString newline)
+ParseEvent
+OutputParser::ParseCdrecordLine(const BString& newline, int32 stream)
 {
-	int32 resultNewline;
-	int32 resultText;
-printf("New line: %s\n", newline.String());
-
-	// does the data not fit on current disc?
-	resultNewline = newline.FindFirst(
-		"cdrecord: WARNING: Data may not fit on current disk.");
-	if (resultNewline != B_ERROR)
-		return SMALLDISC;
-
-	resultNewline = newline.FindFirst(
-		"cdrecord: Data does not fit on current disk.");
-	if (resultNewline != B_ERROR)
-		return SMALLDISC;
-
-	// invalid wavs stopped the burning?
-	resultNewline = newline.FindFirst(
-		"cdrecord: Inappropriate audio coding in");
-	if (resultNewline != B_ERROR)
-		return INVALIDWAV;
-
-	resultNewline = newline.FindFirst(" MB written (fifo");
-	if (resultNewline != B_ERROR) {
-		// calculate percentage
-		BStringList wordList;
-		newline.Split(" ", true, wordList);
-		float currentSize = atof(wordList.StringAt(2));
-		float targetSize = atof(wordList.StringAt(4));
-		progress = currentSize / targetSize;
-	printf("cdrecord, current: %f, target: %f, percentage: %f\n",
-		currentSize, targetSize, progress);
-
-		// calculate ETA
-		bigtime_t now = (bigtime_t)real_time_clock_usecs();
-		float speed = ((currentSize - fLastSize) * 1000000.0
-			/ (now - fLastTime)); // MB/s
-		float secondsLeft = (targetSize - currentSize) / speed;
-		fLastTime = now;
-		fLastSize = currentSize;
-	printf("cdrecord, speed: %f, seconds left: %f\n", speed, secondsLeft);
-
-		BString duration;
-		BDurationFormat formatter;
-		formatter.Format(duration, now, now + ((bigtime_t)secondsLeft * 1000000LL));
-		if (duration == "")
-			eta = B_TRANSLATE("Finished very soon now");
-		else {
-			eta = B_TRANSLATE("Finished in %duration%");
-			eta.ReplaceFirst("%duration%", duration);
-		}
-	printf("ETA: %s\n\n", eta.String());
-
-		// print on top of the last line (not if this is the first progress line)
-		resultText = text.FindFirst(" MB written (fifo");
-		if (resultText != B_ERROR) {
-			int32 offset = text.FindLast("\n");
-			if (offset != B_ERROR)
-				text.Remove(offset, text.CountChars() - offset);
-		}
-		text << "\n" << newline;
-		return PERCENT;
+	uint32 found = CdrecordMatcher().Match(newline);
+	if (found == 0)
+		return _Event(NOCHANGE);
+
+	// cdrecord reports errors on stderr, and its progress on stdout
+	if (stream != STDOUT_FILENO) {
+		// does the data not fit on current disc?
+		if (FOUND(found, kCdrecordMayNotFit) || FOUND(found, kCdrecordNotFit))
+			return _Event(SMALLDISC);
+
+		// invalid wavs stopped the burning?
+		if (FOUND(found, kCdrecordBadAudio))
+			return _Event(INVALIDWAV);
 	}
-	return NOCHANGE;
+	// The summary at the end goes to both streams
+	if (FOUND(found, kCdrecordFifoStats) || FOUND(found, kCdrecordBufferStats)
+		|| FOUND(found, kCdrecordUnderruns)) {
+		_CdrecordSummary(newline, found);
+		return _Event(NOCHANGE);
+	}
+	if (stream == STDERR_FILENO)
+		return _Event(NOCHANGE);
+
+	if (FOUND(found, kCdrecordProgress))
+		return _CdrecordProgress(newline);
+
+	return _Event(NOCHANGE);
 }
 
 
-int32
-OutputParser::ParseIsoinfoLine(BString& text, BString newline)
+ParseEvent
+OutputParser::ParseIsoinfoLine(const BString& newline)
 {
-	return NOCHANGE;
+	return _Event(NOCHANGE);
 }
 
 
 int32
-OutputParser::ParseMediainfoLine(int64& size, BString newline)
+OutputParser::ParseMediainfoLine(int64& size, const BString& newline)
 {
-	int32 resultNewline;
-printf("New line: %s\n", newline.String());
-	resultNewline = newline.FindFirst("Remaining writable size:");
-	if (resultNewline != B_ERROR) {
-		// blank R/RW: get capacity (reported in KiB!)
-		BStringList wordList;
-		newline.Split(" ", true, wordList);
-		size = atoll(wordList.StringAt(3)); // size in KiB
+	uint32 found = MediainfoMatcher().Match(newline);
+	if (FOUND(found, kMediainfoRemaining)) {
+		// blank R/RW: get capacity (reported in 2K blocks as well)
+		size = parse_number<int64>(field_at(view(newline), 3)) * 2;
 	}
-	resultNewline = newline.FindFirst("Last session leadout start address:");
-	if (resultNewline != B_ERROR) {
+	if (FOUND(found, kMediainfoLeadout)) {
 		// CD/DVD: get data size (reported in 2K blocks!)
-		BStringList wordList;
-		newline.Split(" ", true, wordList);
-		size = atoll(wordList.StringAt(5)) * 2;
+		size = parse_number<int64>(field_at(view(newline), 5)) * 2;
 	}
 	return NOCHANGE;
 }
 
 
 int32
-OutputParser::ParseMkisofsLine(BString& text, BString newline)
+OutputParser::ParseMediaRemainingLine(int64& sectors, const BString& newline)
 {
-	int32 resultNewline;
-	int32 resultText;
-printf("New line: %s\n", newline.String());
+	uint32 found = MediainfoMatcher().Match(newline);
+	if (FOUND(found, kMediainfoRemaining))
+		sectors = parse_number<int64>(field_at(view(newline), 3));
+	return NOCHANGE;
+}
+
+
+ParseEvent
+OutputParser::ParseMkisofsLine(const BString& newline, int32 stream)
+{
+	// mkisofs reports its progress on stderr
+	if (stream == STDOUT_FILENO)
+		return _Event(NOCHANGE);
+
 	// detect progress of makeisofs
-	resultNewline = newline.FindFirst("done, estimate finish");
-	if (resultNewline != B_ERROR) {
-		// get the percentage
-		BStringList percentList;
-		newline.Split("%", true, percentList);
-		printf("mkisofs percentage: %s\n", percentList.StringAt(0).String());
-		progress = atof(percentList.StringAt(0)) / 100;
-
-		// get the ETA
-		BString when;
-		int32 charCount = newline.FindFirst("finish");
-		newline.CopyInto(when, charCount + 6, newline.CountChars());
-
-		const char* dateformat("A B d H:M:S Y");
-		set_dateformats(&dateformat);
-		bigtime_t finishTime = parsedate(when, -1);
-		bigtime_t now = (bigtime_t)real_time_clock_usecs();
-
-		BString duration;
-		BDurationFormat formatter;
-		// add 1 sec, otherwise the last second of the progress isn't shown...
-		formatter.Format(duration, now - 1000000LL, finishTime * 1000000LL);
-//		printf("mkisofs duration: %s - now: %i - finish: %i\n\n", duration.String(), now - 1000000LL, finishTime * 1000000LL);
-
-		if (duration == "")
-			eta = B_TRANSLATE("Finished very soon now");
-		else {
-			eta = B_TRANSLATE("Finished in %duration%");
-			eta.ReplaceFirst("%duration%", duration);
-		}
-		// print on top of the last line (not if this is the first progress line)
-		resultText = text.FindFirst("done, estimate finish");
-		if (resultText != B_ERROR) {
-			int32 offset = text.FindLast("\n");
-			if (offset != B_ERROR)
-				text.Remove(offset, text.CountChars() - offset);
-		}
-		text << "\n" << newline;
-		return PERCENT;
+	uint32 found = MkisofsMatcher().Match(newline);
+	if (FOUND(found, kMkisofsProgress))
+		return _MkisofsProgress(newline);
+
+	return _Event(NOCHANGE);
+}
+
+
+ParseEvent
+OutputParser::ParseProgress(int64 bytesDone, int64 bytesTotal)
+{
+	return _SampleProgress(bytesDone, bytesTotal, 1);
+}
+
+
+ParseEvent
+OutputParser::ParseReadcdLine(const BString& newline)
+{
+	uint32 found = ReadcdMatcher().Match(newline);
+	if (FOUND(found, kReadcdCapacity)) {
+		fCapacity = parse_number<float>(field_at(view(newline), 1));
+		return _Event(NOCHANGE);
 	}
-	return NOCHANGE;
+	if (FOUND(found, kReadcdProgress))
+		return _ReadcdProgress(newline);
+
+	return _Event(NOCHANGE);
 }
 
 
-int32
-OutputParser::ParseReadcdLine(BString& text, BString newline)
+void
+OutputParser::Reset()
+{
+	fEstimator.Reset();
+	fEtaSeconds = -1;
+	// Like the views start out, until the next job has an estimate
+	eta = "--";
+	fLastWasProgress = false;
+	fBuffers = BufferStats();
+	fDrainCount = 0;
+}
+
+
+const BufferStats&
+OutputParser::Buffers() const
 {
-	int32 resultNewline;
-	int32 resultText;
-printf("New line: %s\n", newline.String());
-
-	resultNewline = newline.FindFirst("Capacity: ");
-	if (resultNewline != B_ERROR) {
-		BStringList wordList;
-		newline.Split(" ", true, wordList);
-		fCapacity = atof(wordList.StringAt(1));
-		return NOCHANGE;
+	return fBuffers;
+}
+
+
+// The matchers are built on first use, and shared by all parsers
+/*static*/ const PatternMatcher&
+OutputParser::CdrecordMatcher()
+{
+	static const PatternMatcher matcher(kCdrecordPatterns,
+		B_COUNT_OF(kCdrecordPatterns));
+	return matcher;
+}
+
+
+/*static*/ const PatternMatcher&
+OutputParser::MediainfoMatcher()
+{
+	static const PatternMatcher matcher(kMediainfoPatterns,
+		B_COUNT_OF(kMediainfoPatterns));
+	return matcher;
+}
+
+
+/*static*/ const PatternMatcher&
+OutputParser::MkisofsMatcher()
+{
+	static const PatternMatcher matcher(kMkisofsPatterns,
+		B_COUNT_OF(kMkisofsPatterns));
+	return matcher;
+}
+
+
+/*static*/ const PatternMatcher&
+OutputParser::ReadcdMatcher()
+{
+	static const PatternMatcher matcher(kReadcdPatterns,
+		B_COUNT_OF(kReadcdPatterns));
+	return matcher;
+}
+
+
+#pragma mark -- Private Methods --
+
+
+ParseEvent
+OutputParser::_Event(int32 result)
+{
+	// A progress line takes the place of the one before it, if that was one
+	// as well
+	ParseEvent event;
+	event.result = result;
+	event.replaceLine = result == PERCENT && fLastWasProgress;
+	fLastWasProgress = result == PERCENT;
+	return event;
+}
+
+
+ParseEvent
+OutputParser::_CdrecordProgress(const BString& newline)
+{
+	// calculate percentage
+	std::string_view line = view(newline);
+	float currentSize = parse_number<float>(field_at(line, 2));
+	float targetSize = parse_number<float>(field_at(line, 4));
+
+	// cdrecord counts MiB
+	ParseEvent event = _SampleProgress(currentSize, targetSize, 1024 * 1024);
+	event.fifoFill = number_after(line, "(fifo");
+	event.bufferFill = number_after(line, "[buf");
+	event.fifoWarning = _TrackBuffers(event.fifoFill, event.bufferFill,
+		event.bytesTotal - event.bytesDone);
+	return event;
+}
+
+
+void
+OutputParser::_CdrecordSummary(const BString& newline, uint32 found)
+{
+	std::string_view line = view(newline);
+
+	// "fifo was 0 times empty and 1234 times full, min fill was 96%."
+	if (FOUND(found, kCdrecordFifoStats)) {
+		fBuffers.fifoEmpty = number_after(line, "fifo was");
+		int32 minFill = number_after(line, "min fill was");
+		if (minFill >= 0)
+			fBuffers.minFifoFill = minFill;
 	}
-	resultNewline = newline.FindFirst("addr:");
-	if (resultNewline != B_ERROR) {
-		// calculate percentage
-		BStringList wordList;
-		newline.Split(" ", true, wordList);
-		float currentSize = atof(wordList.StringAt(1));
-		progress = currentSize / fCapacity;
-	printf("cdrecord, current: %f, target: %f, percentage: %f\n",
-		currentSize, fCapacity, progress);
-
-		// calculate ETA
-		bigtime_t now = (bigtime_t)real_time_clock_usecs();
-		float speed = ((currentSize - fLastSize) * 1000000.0
-			/ (now - fLastTime)); // MB/s
-		float secondsLeft = (fCapacity - currentSize) / speed;
-		fLastTime = now;
-		fLastSize = currentSize;
-	printf("cdrecord, speed: %f, seconds left: %f\n", speed, secondsLeft);
-
-		BString duration;
-		BDurationFormat formatter;
-		formatter.Format(duration, now, now + ((bigtime_t)secondsLeft * 1000000LL));
-		if (duration == "")
-			eta = B_TRANSLATE("Finished very soon now");
-		else {
-			eta = B_TRANSLATE("Finished in %duration%");
-			eta.ReplaceFirst("%duration%", duration);
-		}
-	printf("ETA: %s\n\n", eta.String());
-
-		// print on top of the last line (not if this is the first progress line)
-		resultText = text.FindFirst("addr:");
-		if (resultText != B_ERROR) {
-			int32 offset = text.FindLast("\n");
-			if (offset != B_ERROR)
-				text.Remove(offset, text.CountChars() - offset);
-		}
-		text << "\n" << newline;
-		return PERCENT;
+	// "Min drive buffer fill was 99%"
+	if (FOUND(found, kCdrecordBufferStats)) {
+		int32 minFill = number_after(line, "buffer fill was");
+		if (minFill >= 0)
+			fBuffers.minBufferFill = minFill;
 	}
-	return NOCHANGE;
+	// "Total of 0 possible drive buffer underruns predicted."
+	if (FOUND(found, kCdrecordUnderruns))
+		fBuffers.underruns = number_after(line, "Total of");
+}
+
+
+ParseEvent
+OutputParser::_MkisofsProgress(const BString& newline)
+{
+	// get the percentage, the time left is estimated from how fast it grows
+	float percentage = parse_number<float>(field_at(view(newline), 0, '%'));
+
+	return _SampleProgress(percentage, 100, 0);
+}
+
+
+ParseEvent
+OutputParser::_ReadcdProgress(const BString& newline)
+{
+	// calculate percentage
+	float currentSize = parse_number<float>(field_at(view(newline), 1));
+
+	// readcd counts 2048 byte sectors
+	return _SampleProgress(currentSize, fCapacity, 2048);
+}
+
+
+ParseEvent
+OutputParser::_SampleProgress(double done, double total, double unit)
+{
+	// "unit" is the size of what "done" and "total" count in bytes, 0 if they
+	// don't count bytes
+	if (total > 0)
+		progress = done / total;
+
+	fEstimator.AddSample(done, total);
+	bigtime_t timeLeft = fEstimator.TimeLeft();
+	_SetEta(timeLeft);
+
+	ParseEvent event = _Event(PERCENT);
+	event.progress = progress;
+	event.timeLeft = timeLeft;
+	if (unit > 0) {
+		event.bytesDone = (int64)(done * unit);
+		event.bytesTotal = (int64)(total * unit);
+		if (fEstimator.Speed() >= 0)
+			event.speed = fEstimator.Speed() * unit;
+		if (fEstimator.AverageSpeed() >= 0)
+			event.averageSpeed = fEstimator.AverageSpeed() * unit;
+	}
+	return event;
 }
 
 
 void
-OutputParser::Reset()
+OutputParser::_SetEta(bigtime_t timeLeft)
+{
+	// Keep what's shown until there's an estimate
+	if (timeLeft < 0)
+		return;
+
+	int64 seconds = (timeLeft + 500000) / 1000000;
+	if (seconds == fEtaSeconds)
+		return;
+	fEtaSeconds = seconds;
+
+	if (seconds == 0) {
+		eta = fFinishedSoon;
+		return;
+	}
+
+	BString duration;
+	fDurationFormat.Format(duration, 0, seconds * 1000000LL);
+	eta = fFinishedIn;
+	eta.ReplaceFirst("%duration%", duration);
+}
+
+
+bool
+OutputParser::_TrackBuffers(int32 fifoFill, int32 bufferFill,
+	int64 bytesLeft)
 {
-	fLastTime = (bigtime_t)real_time_clock_usecs() - 1000000LL; // now - 1 sec
-	fLastSize = 0;
+	// Returns true when the fifo just started to run low
+	if (bufferFill >= 0) {
+		if (fBuffers.minBufferFill < 0 || bufferFill < fBuffers.minBufferFill)
+			fBuffers.minBufferFill = bufferFill;
+		fBuffers.bufferFill = bufferFill;
+	}
+	if (fifoFill < 0)
+		return false;
+
+	if (fBuffers.fifoFill >= 0 && fifoFill < fBuffers.fifoFill)
+		fDrainCount++;
+	else if (fifoFill > fBuffers.fifoFill)
+		fDrainCount = 0;
+
+	if (fBuffers.minFifoFill < 0 || fifoFill < fBuffers.minFifoFill)
+		fBuffers.minFifoFill = fifoFill;
+	fBuffers.fifoFill = fifoFill;
+
+	if (fBuffers.fifoLow || bytesLeft < kFifoTail)
+		return false;
+
+	fBuffers.fifoLow = fifoFill < kCriticalFifoFill
+		|| (fifoFill < kLowFifoFill && fDrainCount >= kDrainLines);
+	return fBuffers.fifoLow;
 }
@@ -8,30 +8,113 @@
 #ifndef OUTPUTPARSER_H
 #define OUTPUTPARSER_H
 
+#include <DurationFormat.h>
 #include <String.h>
 #include <SupportDefs.h>
 
+#include "ProgressEstimator.h"
+
+
+class PatternMatcher;
+
+
+// What a line of output means. Unknown values are negative.
+struct ParseEvent {
+				ParseEvent();
+
+	// NOCHANGE, PERCENT, SMALLDISC or INVALIDWAV
+	int32		result;
+	// The line takes the place of the last one in the output
+	bool		replaceLine;
+
+	float		progress;	// from 0 to 1
+	int64		bytesDone;
+	int64		bytesTotal;
+	float		speed;		// in bytes per second, of the last moments
+	float		averageSpeed;	// in bytes per second, since the start
+	int32		fifoFill;	// in percent
+	int32		bufferFill;	// in percent
+	bigtime_t	timeLeft;
+	// cdrecord's fifo started to run low with this line
+	bool		fifoWarning;
+};
+
+
+// How cdrecord's fifo and the buffer of the drive did during a burn. Unknown
+// values are negative.
+struct BufferStats {
+				BufferStats();
+
+	int32		fifoFill;		// in percent, the last ones reported
+	int32		bufferFill;
+	int32		minFifoFill;	// in percent, the lowest ones seen
+	int32		minBufferFill;
+	// From the summary cdrecord writes at the end
+	int32		fifoEmpty;		// how often the fifo ran empty
+	int32		underruns;		// possible buffer underruns of the drive
+	// The fifo kept draining during the burn
+	bool		fifoLow;
+};
+
 
 class OutputParser {
 public:
 				OutputParser(float& noteProgress, BString& noteEta);
 	virtual		~OutputParser();
 
-	int32		ParseBlankLine(BString& text, BString newline);
-	int32		ParseCdrecordLine(BString& text, BString newline);
-	int32		ParseIsoinfoLine(BString& text, BString newline);
-	int32		ParseMediainfoLine(int64& size, BString newline);
-	int32		ParseMkisofsLine(BString& text, BString newline);
-	int32		ParseReadcdLine(BString& text, BString newline);
+	// The parsers don't touch the output shown, they only report what a line
+	// means. Lines are expected in the order they were written.
+	ParseEvent	ParseBlankLine(const BString& newline);
+	// "stream" is the stream the line came from, STDOUT_FILENO or
+	// STDERR_FILENO, or -1 if unknown. Only the messages a command
+	// actually writes to that stream are looked for.
+	ParseEvent	ParseCdrecordLine(const BString& newline, int32 stream = -1);
+	ParseEvent	ParseIsoinfoLine(const BString& newline);
+	int32		ParseMediainfoLine(int64& size, const BString& newline);
+	// The room left on a blank or appendable disc, in 2 KiB sectors
+	int32		ParseMediaRemainingLine(int64& sectors,
+					const BString& newline);
+	ParseEvent	ParseMkisofsLine(const BString& newline, int32 stream = -1);
+	// For progress that isn't parsed from a command, like that of IsoWriter
+	ParseEvent	ParseProgress(int64 bytesDone, int64 bytesTotal);
+	ParseEvent	ParseReadcdLine(const BString& newline);
 	void		Reset();
 
+	const BufferStats& Buffers() const;
+
+	// The messages looked for in the output of each tool
+	static const PatternMatcher& CdrecordMatcher();
+	static const PatternMatcher& MediainfoMatcher();
+	static const PatternMatcher& MkisofsMatcher();
+	static const PatternMatcher& ReadcdMatcher();
+
 private:
+	ParseEvent	_Event(int32 result);
+	ParseEvent	_CdrecordProgress(const BString& newline);
+	void		_CdrecordSummary(const BString& newline, uint32 found);
+	ParseEvent	_MkisofsProgress(const BString& newline);
+	ParseEvent	_ReadcdProgress(const BString& newline);
+	ParseEvent	_SampleProgress(double done, double total, double unit);
+	void		_SetEta(bigtime_t timeLeft);
+	bool		_TrackBuffers(int32 fifoFill, int32 bufferFill,
+					int64 bytesLeft);
+
 	float&		progress;
 	BString& 	eta;
 
-	bigtime_t	fLastTime;
-	float		fLastSize;
+	ProgressEstimator fEstimator;
 	float		fCapacity;
+
+	// Formatting the time left is costly, it's only done when the seconds
+	// shown change
+	BDurationFormat fDurationFormat;
+	BString		fFinishedIn;
+	BString		fFinishedSoon;
+	int64		fEtaSeconds;
+	bool		fLastWasProgress;
+
+	BufferStats	fBuffers;
+	int32		fDrainCount;
 };
 
 #endif // OUTPUTPARSER_H
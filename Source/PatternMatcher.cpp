@@ -0,0 +1,119 @@
+/*
+ * Copyright 2026, BurnItNow Team. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "PatternMatcher.h"
+
+#include <string.h>
+
+
+PatternMatcher::PatternMatcher(const char* const* patterns, int32 count)
+	:
+	fPatterns(patterns, patterns + count),
+	fClassCount(1)
+{
+	// Only bytes that occur in a pattern get a class of their own, all others
+	// share class 0, which always leads back to the start. That keeps the
+	// table small enough to stay in the cache.
+	memset(fClasses, 0, sizeof(fClasses));
+	for (int32 i = 0; i < count; i++) {
+		for (const uint8* c = (const uint8*)patterns[i]; *c != '\0'; c++) {
+			if (fClasses[*c] == 0)
+				fClasses[*c] = fClassCount++;
+		}
+	}
+
+	// Build the trie of all patterns
+	_AddState();
+	for (int32 i = 0; i < count && i < 32; i++) {
+		int32 state = 0;
+		for (const uint8* c = (const uint8*)patterns[i]; *c != '\0'; c++) {
+			int32& next = fTransitions[state * fClassCount + fClasses[*c]];
+			if (next < 0) {
+				int32 added = _AddState();
+				// _AddState() may have moved the table
+				fTransitions[state * fClassCount + fClasses[*c]] = added;
+				state = added;
+			} else
+				state = next;
+		}
+		fOutputs[state] |= 1UL << i;
+	}
+
+	// Turn it into a complete state machine: missing transitions go where
+	// the longest suffix that is also a pattern prefix would go. Breadth
+	// first, so that the states of shorter prefixes are done already.
+	std::vector<int32> fallback(fOutputs.size(), 0);
+	std::vector<int32> queue;
+	for (int32 c = 0; c < fClassCount; c++) {
+		int32& next = fTransitions[c];
+		if (next < 0)
+			next = 0;
+		else
+			queue.push_back(next);
+	}
+
+	for (size_t i = 0; i < queue.size(); i++) {
+		int32 state = queue[i];
+		fOutputs[state] |= fOutputs[fallback[state]];
+
+		for (int32 c = 0; c < fClassCount; c++) {
+			int32& next = fTransitions[state * fClassCount + c];
+			int32 other = fTransitions[fallback[state] * fClassCount + c];
+			if (next < 0)
+				next = other;
+			else {
+				fallback[next] = other;
+				queue.push_back(next);
+			}
+		}
+	}
+}
+
+
+uint32
+PatternMatcher::Match(const char* text, int32 length) const
+{
+	const int32* transitions = &fTransitions[0];
+	const uint32* outputs = &fOutputs[0];
+
+	uint32 found = 0;
+	int32 state = 0;
+	for (int32 i = 0; i < length; i++) {
+		state = transitions[state * fClassCount + fClasses[(uint8)text[i]]];
+		found |= outputs[state];
+	}
+	return found;
+}
+
+
+uint32
+PatternMatcher::Match(const BString& text) const
+{
+	return Match(text.String(), text.Length());
+}
+
+
+int32
+PatternMatcher::_AddState()
+{
+	int32 state = fOutputs.size();
+	fTransitions.resize(fTransitions.size() + fClassCount, -1);
+	fOutputs.push_back(0);
+	return state;
+}
+
+
+int32
+PatternMatcher::CountPatterns() const
+{
+	return (int32)fPatterns.size();
+}
+
+
+const char*
+PatternMatcher::PatternAt(int32 index) const
+{
+	return fPatterns[index].c_str();
+}
@@ -0,0 +1,45 @@
+/*
+ * Copyright 2026, BurnItNow Team. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _PATTERNMATCHER_H_
+#define _PATTERNMATCHER_H_
+
+
+#include <String.h>
+#include <SupportDefs.h>
+
+#include <string>
+#include <vector>
+
+
+// Looks for a fixed set of strings in a text, all of them at once and in a
+// single pass (Aho-Corasick). The patterns are compiled into a state table
+// when it is created, after that it can be used from any thread.
+// Up to 32 patterns are supported, pattern i is reported as bit i.
+class PatternMatcher {
+public:
+					PatternMatcher(const char* const* patterns,
+						int32 count);
+
+	// Returns the patterns found in "text" as a bit mask, 0 if none is
+	uint32			Match(const char* text, int32 length) const;
+	uint32			Match(const BString& text) const;
+
+	int32			CountPatterns() const;
+	const char*		PatternAt(int32 index) const;
+
+private:
+	int32			_AddState();
+
+	std::vector<std::string> fPatterns;
+	uint8			fClasses[256];
+	int32			fClassCount;
+	// fClassCount transitions per state, state 0 is the start
+	std::vector<int32> fTransitions;
+	// The patterns that end in each state
+	std::vector<uint32> fOutputs;
+};
+
+
+#endif	// _PATTERNMATCHER_H_
@@ -0,0 +1,63 @@
+/*
+ * Copyright 2026, BurnItNow Team. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "ProgressController.h"
+
+#include <Notification.h>
+
+
+ProgressController::ProgressController(bigtime_t interval)
+	:
+	fInterval(interval),
+	fLastSent(0),
+	fPending(false),
+	fProgress(0)
+{
+}
+
+
+bool
+ProgressController::Update(const char* messageID, const char* title,
+	const char* content, float progress)
+{
+	fMessageID = messageID;
+	fTitle = title;
+	fContent = content;
+	fProgress = progress;
+	fPending = true;
+
+	if (system_time() - fLastSent < fInterval)
+		return false;
+
+	_Send();
+	return true;
+}
+
+
+bool
+ProgressController::Flush()
+{
+	if (!fPending)
+		return false;
+
+	_Send();
+	return true;
+}
+
+
+void
+ProgressController::_Send()
+{
+	BNotification progress(B_PROGRESS_NOTIFICATION);
+	progress.SetGroup("BurnItNow");
+	progress.SetTitle(fTitle);
+	progress.SetContent(fContent);
+	progress.SetProgress(fProgress);
+	progress.SetMessageID(fMessageID);
+	progress.Send();
+
+	fLastSent = system_time();
+	fPending = false;
+}
@@ -0,0 +1,43 @@
+/*
+ * Copyright 2026, BurnItNow Team. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _PROGRESSCONTROLLER_H_
+#define _PROGRESSCONTROLLER_H_
+
+
+#include <OS.h>
+#include <String.h>
+
+
+// Shows the progress of a job as notification. The views hand it every new
+// value, it only sends one at most every "interval", the notification server
+// doesn't need to hear about each line a tool writes.
+// What is held back is sent with the next update that's due, or by Flush(),
+// which has to be called when the job is done.
+class ProgressController {
+public:
+					ProgressController(bigtime_t interval = 250000);
+
+	// Returns true if the notification was sent now. That's also when
+	// anything else that shows the progress is worth updating.
+	bool			Update(const char* messageID, const char* title,
+						const char* content, float progress);
+	// Sends the last update if it was held back, and returns true if it was
+	bool			Flush();
+
+private:
+	void			_Send();
+
+	bigtime_t		fInterval;
+	bigtime_t		fLastSent;
+	bool			fPending;
+
+	BString			fMessageID;
+	BString			fTitle;
+	BString			fContent;
+	float			fProgress;
+};
+
+
+#endif	// _PROGRESSCONTROLLER_H_
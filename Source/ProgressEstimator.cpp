@@ -0,0 +1,107 @@
+/*
+ * Copyright 2026, BurnItNow Team. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "ProgressEstimator.h"
+
+#include <math.h>
+
+
+// Samples closer together than this are taken as one. Tools often write a
+// few lines at once, their timing says nothing about the speed.
+static const bigtime_t kMinInterval = 250000LL;
+
+
+ProgressEstimator::ProgressEstimator(bigtime_t halfLife)
+	:
+	fHalfLife(halfLife)
+{
+	Reset();
+}
+
+
+void
+ProgressEstimator::Reset()
+{
+	fStarted = false;
+	fStartTime = fLastTime = 0;
+	fStartDone = fLastDone = fDone = 0;
+	fTotal = 0;
+	fSpeed = fSmoothedSpeed = -1;
+}
+
+
+void
+ProgressEstimator::AddSample(double done, double total, bigtime_t when)
+{
+	fDone = done;
+	fTotal = total;
+
+	if (!fStarted || done < fLastDone) {
+		// The first sample, or the task started over
+		fStarted = true;
+		fStartTime = fLastTime = when;
+		fStartDone = fLastDone = done;
+		fSpeed = fSmoothedSpeed = -1;
+		return;
+	}
+
+	bigtime_t interval = when - fLastTime;
+	if (interval < kMinInterval)
+		return;
+
+	fSpeed = (done - fLastDone) * 1000000.0 / interval;
+	if (fSmoothedSpeed < 0)
+		fSmoothedSpeed = fSpeed;
+	else {
+		// Weigh by the time that passed, the samples don't come in regularly.
+		// Early on it's the plain average, so a fast start doesn't linger.
+		double weight = 1.0 - exp2(-(double)interval / fHalfLife);
+		double share = (double)interval / (when - fStartTime);
+		if (share > weight)
+			weight = share;
+		fSmoothedSpeed += weight * (fSpeed - fSmoothedSpeed);
+	}
+
+	fLastTime = when;
+	fLastDone = done;
+}
+
+
+double
+ProgressEstimator::Speed() const
+{
+	return fSpeed;
+}
+
+
+double
+ProgressEstimator::AverageSpeed() const
+{
+	if (fSpeed < 0 || fLastTime <= fStartTime)
+		return -1;
+
+	return (fLastDone - fStartDone) * 1000000.0 / (fLastTime - fStartTime);
+}
+
+
+double
+ProgressEstimator::SmoothedSpeed() const
+{
+	return fSmoothedSpeed;
+}
+
+
+bigtime_t
+ProgressEstimator::TimeLeft() const
+{
+	if (fSmoothedSpeed <= 0 || fTotal <= 0)
+		return -1;
+
+	double left = fTotal - fDone;
+	if (left <= 0)
+		return 0;
+
+	return (bigtime_t)(left / fSmoothedSpeed * 1000000.0);
+}
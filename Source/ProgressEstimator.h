@@ -0,0 +1,52 @@
+/*
+ * Copyright 2026, BurnItNow Team. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _PROGRESSESTIMATOR_H_
+#define _PROGRESSESTIMATOR_H_
+
+
+#include <OS.h>
+#include <SupportDefs.h>
+
+
+// Estimates the speed of a task and the time it has left, from samples of
+// how much of it is done. The unit of the samples doesn't matter, the speeds
+// are given in the same unit per second.
+// The speed the time left is based on is an exponentially weighted moving
+// average, so it doesn't jump around with every refill of a buffer. The
+// weight of a sample halves every "halfLife".
+class ProgressEstimator {
+public:
+						ProgressEstimator(bigtime_t halfLife = 5000000LL);
+
+	void				Reset();
+	void				AddSample(double done, double total,
+							bigtime_t when = system_time());
+
+	// Between the last two samples used, -1 if there weren't two yet
+	double				Speed() const;
+	// Since the first sample, -1 if there weren't two yet
+	double				AverageSpeed() const;
+	// The moving average, -1 if there weren't two samples yet
+	double				SmoothedSpeed() const;
+	// -1 as long as it's unknown
+	bigtime_t			TimeLeft() const;
+
+private:
+	bigtime_t			fHalfLife;
+
+	bool				fStarted;
+	bigtime_t			fStartTime;
+	double				fStartDone;
+	bigtime_t			fLastTime;
+	double				fLastDone;
+	double				fDone;
+	double				fTotal;
+
+	double				fSpeed;
+	double				fSmoothedSpeed;
+};
+
+
+#endif	// _PROGRESSESTIMATOR_H_
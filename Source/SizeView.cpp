@@ -43,10 +43,16 @@ SizeView::SizeView()
 	fProjectSize->SetFontSize(be_plain_font->Size() - 2);
 	fProjectSize->SetHighColor(tint_color(ui_color(B_CONTROL_TEXT_COLOR), 0.7));
 
+	fBufferFill = new BStringView("bufferfill", "");
+	fBufferFill->SetAlignment(B_ALIGN_CENTER);
+	fBufferFill->SetFontSize(be_plain_font->Size() - 2);
+	fBufferFill->Hide();
+
 	BLayoutBuilder::Group<>(this, B_HORIZONTAL, kControlPadding)
 		.AddGroup(B_VERTICAL, 0)
 			.Add(fSpaceLeft)
 			.Add(fProjectSize)
+			.Add(fBufferFill)
 			.End()
 		.Add(fSizeBar);
 }
@@ -167,7 +173,57 @@ SizeView::UpdateSizeDisplay(off_t fileSize, int32 mode,
 
 
 void
-SizeView::ShowInfoText(const char* info)
+SizeView::ShowInfoText(const char* info, int64 files)
+{
+	if (files < 0) {
+		fSpaceLeft->SetText(info);
+		return;
+	}
+
+	BString text(B_TRANSLATE_COMMENT("%info% (%files% files)",
+		"Size view while counting; don't translate the variables"));
+	text.ReplaceFirst("%info%", info);
+	text.ReplaceFirst("%files%", BString() << files);
+	fSpaceLeft->SetText(text);
+}
+
+
+void
+SizeView::ShowBufferFill(int32 fifoFill, int32 bufferFill, bool warning)
+{
+	BString fill;
+	if (fifoFill >= 0) {
+		fill = B_TRANSLATE_COMMENT("Fifo: %fill%%",
+			"Fill level of the burn fifo; don't translate the variable");
+		fill.ReplaceFirst("%fill%", BString() << fifoFill);
+	}
+	if (bufferFill >= 0) {
+		BString buffer(B_TRANSLATE_COMMENT("Drive buffer: %fill%%",
+			"Fill level of the drive buffer; don't translate the variable"));
+		buffer.ReplaceFirst("%fill%", BString() << bufferFill);
+		if (!fill.IsEmpty())
+			fill << "   ";
+		fill << buffer;
+	}
+	fBufferFill->SetText(fill);
+
+	// A fifo that keeps running low may end in a buffer underrun
+	if (warning)
+		fBufferFill->SetHighColor(ui_color(B_FAILURE_COLOR));
+	else {
+		fBufferFill->SetHighColor(
+			tint_color(ui_color(B_CONTROL_TEXT_COLOR), 0.7));
+	}
+	fBufferFill->Invalidate();
+
+	if (fBufferFill->IsHidden())
+		fBufferFill->Show();
+}
+
+
+void
+SizeView::HideBufferFill()
 {
-	fSpaceLeft->SetText(info);
+	if (!fBufferFill->IsHidden())
+		fBufferFill->Hide();
 }
@@ -20,12 +20,20 @@ public:
 
 	void			UpdateSizeDisplay(off_t fileSize, int32 mode,
 						int32 medium);
-	void			ShowInfoText(const char* info);
+	// With "files", how many of them were found so far is added
+	void			ShowInfoText(const char* info, int64 files = -1);
+
+	// Shows the fill levels of cdrecord's fifo and the drive buffer while
+	// burning, in percent. Negative values are left out.
+	void			ShowBufferFill(int32 fifoFill, int32 bufferFill,
+						bool warning);
+	void			HideBufferFill();
 
 private:
 	SizeBar*		fSizeBar;
 	BStringView*	fSpaceLeft;
 	BStringView*	fProjectSize;
+	BStringView*	fBufferFill;
 };
 
 #endif	// _SIZEVIEW_H_
@@ -0,0 +1,424 @@
+/*
+ * Copyright 2026, BurnItNow Team. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+// Builds an image of a folder with IsoWriter, and checks it against what
+// cdrtools make of it: "isoinfo -d" has to find the volume, Joliet and Rock
+// Ridge, the listings of "isoinfo -l", "-J -l" and "-R -l" have to be the
+// same as those of the image mkisofs builds of the folder, and so has the
+// size "mkisofs -print-size" tells.
+//
+//	IsoWriterTest [<scratch folder>]
+//
+// The folder that is built has names that clash on ISO 9660 and in Joliet,
+// long Joliet names, symlinks, hard links, folders deeper than ISO 9660
+// allows, and a sparse file larger than 4 GiB. The images are built one
+// after the other in the scratch folder, "/tmp" by default, so it needs
+// room for one of them, about 4.3 GB. With less room, the large file is
+// left out.
+// Without isoinfo and mkisofs, nothing is tested.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "IsoWriter.h"
+
+
+static const char* kVolumeName = "ISOWRITERTEST";
+static const char* kImageOptions = "-iso-level 3 -J -joliet-long -rock";
+static const off_t kLargeFileSize = (4LL << 30) + 12345;
+// Room for an image with the large file, and the rest of the folder
+static const off_t kNeededSpace = kLargeFileSize + (64LL << 20);
+
+
+static int sFailures = 0;
+
+
+static void
+fail(const char* what, const std::string& detail = "")
+{
+	fprintf(stderr, "FAIL: %s\n", what);
+	if (!detail.empty())
+		fprintf(stderr, "%s\n", detail.c_str());
+	sFailures++;
+}
+
+
+static std::string
+quoted(const std::string& text)
+{
+	std::string quoted = "'";
+	for (size_t i = 0; i < text.size(); i++) {
+		if (text[i] == '\'')
+			quoted += "'\\''";
+		else
+			quoted += text[i];
+	}
+	return quoted + "'";
+}
+
+
+// Runs "command" with a shell, and returns what it wrote to stdout
+static bool
+run(const std::string& command, std::string& output)
+{
+	output.clear();
+	FILE* pipe = popen(command.c_str(), "r");
+	if (pipe == NULL)
+		return false;
+
+	char buffer[4096];
+	size_t length;
+	while ((length = fread(buffer, 1, sizeof(buffer), pipe)) > 0)
+		output.append(buffer, length);
+	return pclose(pipe) == 0;
+}
+
+
+static bool
+has_tool(const char* name)
+{
+	std::string output;
+	return run(std::string("which ") + name + " 2>/dev/null", output);
+}
+
+
+static std::vector<std::string>
+split_lines(const std::string& text)
+{
+	std::vector<std::string> lines;
+	size_t start = 0;
+	while (start < text.size()) {
+		size_t end = text.find('\n', start);
+		if (end == std::string::npos)
+			end = text.size();
+		lines.push_back(text.substr(start, end - start));
+		start = end + 1;
+	}
+	return lines;
+}
+
+
+#pragma mark -- The folder --
+
+
+static bool
+make_folder(const std::string& path)
+{
+	if (mkdir(path.c_str(), 0755) == 0 || errno == EEXIST)
+		return true;
+
+	fail("Couldn't create a folder", path + ": " + strerror(errno));
+	return false;
+}
+
+
+static bool
+make_file(const std::string& path, const std::string& contents)
+{
+	FILE* file = fopen(path.c_str(), "w");
+	if (file == NULL) {
+		fail("Couldn't create a file", path + ": " + strerror(errno));
+		return false;
+	}
+	fwrite(contents.data(), 1, contents.size(), file);
+	fclose(file);
+	return true;
+}
+
+
+static bool
+make_symlink(const char* target, const std::string& path)
+{
+	if (symlink(target, path.c_str()) == 0)
+		return true;
+
+	fail("Couldn't create a symlink", path + ": " + strerror(errno));
+	return false;
+}
+
+
+static bool
+make_tree(const std::string& root, bool largeFile)
+{
+	if (!make_folder(root))
+		return false;
+
+	// They all become READ_ME.TXT on ISO 9660
+	bool ok = make_file(root + "/Read Me.txt", "1")
+		&& make_file(root + "/read_me.txt", "22")
+		&& make_file(root + "/READ-ME.TXT", "333")
+		&& make_file(root + "/read.me.txt", "4444");
+
+	// Cut to the same 30 characters, and folders to the same 31
+	std::string longName = "a_file_name_that_is_too_long_for_iso_9660_";
+	ok = ok && make_file(root + "/" + longName + "1.txt", "first")
+		&& make_file(root + "/" + longName + "2.txt", "second")
+		&& make_folder(root + "/My Folder") && make_folder(root + "/my_folder")
+		&& make_file(root + "/My Folder/inside.txt", "inside")
+		&& make_file(root + "/my_folder/inside.txt", "other inside");
+
+	// Over the 103 characters of Joliet, the first two the same up to there
+	std::string joliet = "Joliet";
+	while (joliet.size() < 110)
+		joliet += " name";
+	ok = ok && make_folder(root + "/long")
+		&& make_file(root + "/long/" + joliet + " A.txt", "a")
+		&& make_file(root + "/long/" + joliet + " B.txt", "b")
+		&& make_file(root + "/long/" + joliet.substr(0, 90) + ".txt", "c")
+		&& make_file(root + "/long/Grüße, Ärger & Öl.txt", "utf-8");
+
+	ok = ok && make_folder(root + "/links")
+		&& make_file(root + "/links/target.txt", "target")
+		&& make_symlink("target.txt", root + "/links/to file")
+		&& make_symlink("../long", root + "/links/to folder")
+		&& make_symlink("/boot/system", root + "/links/absolute")
+		&& make_symlink("nowhere/to/be/found", root + "/links/dangling");
+
+	ok = ok && make_folder(root + "/hard")
+		&& make_file(root + "/hard/original.dat", std::string(5000, 'h'));
+	if (ok && link((root + "/hard/original.dat").c_str(),
+			(root + "/hard/second name.dat").c_str()) != 0) {
+		fail("Couldn't create a hard link", strerror(errno));
+		ok = false;
+	}
+	if (ok && link((root + "/hard/original.dat").c_str(),
+			(root + "/links/third name.dat").c_str()) != 0) {
+		fail("Couldn't create a hard link", strerror(errno));
+		ok = false;
+	}
+
+	// Two chains beyond the 8 levels, their folders of the same names end
+	// up in "rr_moved" together
+	const char* chains[] = { "deep", "deeper" };
+	for (int chain = 0; ok && chain < 2; chain++) {
+		std::string path = root + "/" + chains[chain];
+		ok = make_folder(path);
+		for (int level = 1; ok && level <= 12; level++) {
+			char name[16];
+			snprintf(name, sizeof(name), "level %d", level);
+			path += "/";
+			path += name;
+			ok = make_folder(path)
+				&& make_file(path + "/file.txt", path.substr(root.size()));
+		}
+	}
+
+	if (ok && largeFile) {
+		// Takes no room on the disk, but two extents on the disc
+		ok = make_folder(root + "/large");
+		std::string path = root + "/large/sparse.bin";
+		int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (fd < 0 || ftruncate(fd, kLargeFileSize) != 0
+			|| pwrite(fd, "end", 3, kLargeFileSize - 3) != 3) {
+			fail("Couldn't create the large file", strerror(errno));
+			ok = false;
+		}
+		if (fd >= 0)
+			close(fd);
+	}
+	return ok;
+}
+
+
+#pragma mark -- The checks --
+
+
+// Only what both images have to agree on is kept of each line: the kind
+// and permissions, the size of files, and the name. Dates, locations and
+// the sizes of folders are left out.
+static std::string
+listing(const std::string& options, const std::string& image)
+{
+	std::string output;
+	if (!run("isoinfo " + options + " -l -i " + quoted(image)
+			+ " 2>/dev/null", output)) {
+		fail(("isoinfo " + options + " -l failed").c_str());
+		return "";
+	}
+
+	std::string kept;
+	std::vector<std::string> lines = split_lines(output);
+	for (size_t i = 0; i < lines.size(); i++) {
+		const std::string& line = lines[i];
+		if (line.compare(0, 21, "Directory listing of ") == 0) {
+			kept += line + "\n";
+			continue;
+		}
+
+		size_t nameStart = line.find("]  ");
+		if (nameStart == std::string::npos)
+			continue;
+		std::string name = line.substr(nameStart + 3);
+		while (!name.empty() && name[name.size() - 1] == ' ')
+			name.resize(name.size() - 1);
+
+		char mode[32];
+		unsigned links;
+		unsigned owner;
+		unsigned group;
+		long long size;
+		if (sscanf(line.c_str(), "%31s %u %u %u %lld", mode, &links, &owner,
+				&group, &size) != 5)
+			continue;
+
+		kept += mode;
+		if (mode[0] != 'd') {
+			char text[32];
+			snprintf(text, sizeof(text), " %lld", size);
+			kept += text;
+		}
+		kept += " " + name + "\n";
+	}
+	return kept;
+}
+
+
+static void
+compare_listings(const char* what, const std::string& written,
+	const std::string& expected)
+{
+	if (written == expected)
+		return;
+
+	std::vector<std::string> writtenLines = split_lines(written);
+	std::vector<std::string> expectedLines = split_lines(expected);
+	size_t line = 0;
+	while (line < writtenLines.size() && line < expectedLines.size()
+		&& writtenLines[line] == expectedLines[line])
+		line++;
+
+	std::string detail = "  IsoWriter: ";
+	detail += line < writtenLines.size() ? writtenLines[line] : "(the end)";
+	detail += "\n  mkisofs:   ";
+	detail += line < expectedLines.size() ? expectedLines[line] : "(the end)";
+	fail(what, detail);
+}
+
+
+static void
+check_description(const std::string& image, uint32 sectors)
+{
+	std::string output;
+	if (!run("isoinfo -d -i " + quoted(image) + " 2>/dev/null", output)) {
+		fail("isoinfo -d failed");
+		return;
+	}
+
+	if (output.find(std::string("Volume id: ") + kVolumeName)
+			== std::string::npos)
+		fail("isoinfo -d doesn't find the volume name", output);
+	if (output.find("Joliet with UCS level 3 found") == std::string::npos)
+		fail("isoinfo -d doesn't find Joliet", output);
+	if (output.find("Rock Ridge signatures version 1 found")
+			== std::string::npos)
+		fail("isoinfo -d doesn't find Rock Ridge", output);
+
+	const char* size = strstr(output.c_str(), "Volume size is: ");
+	if (size == NULL || strtoul(size + 16, NULL, 10) != sectors) {
+		char text[64];
+		snprintf(text, sizeof(text), "IsoWriter wrote %u sectors",
+			(unsigned)sectors);
+		fail("isoinfo -d has another volume size", text);
+	}
+}
+
+
+static uint32
+mkisofs_size(const std::string& folder)
+{
+	// Written on a line of its own to stdout, when that's not a terminal
+	std::string output;
+	if (!run(std::string("mkisofs ") + kImageOptions + " -V " + kVolumeName
+			+ " -print-size -quiet " + quoted(folder) + " 2>/dev/null",
+			output)) {
+		fail("mkisofs -print-size failed");
+		return 0;
+	}
+	return strtoul(output.c_str(), NULL, 10);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	if (!has_tool("isoinfo") || !has_tool("mkisofs")) {
+		printf("isoinfo or mkisofs of cdrtools not found, skipped\n");
+		return 0;
+	}
+
+	std::string scratch = argc > 1 ? argv[1] : "/tmp";
+	char name[64];
+	snprintf(name, sizeof(name), "/IsoWriterTest-%d", (int)getpid());
+	std::string base = scratch + name;
+	std::string folder = base + "/folder";
+	std::string image = base + "/image.iso";
+
+	struct statvfs volume;
+	bool largeFile = statvfs(scratch.c_str(), &volume) == 0
+		&& (off_t)volume.f_bavail * volume.f_frsize >= kNeededSpace;
+	if (!largeFile)
+		printf("Not enough room in %s, the file over 4 GiB is left out\n",
+			scratch.c_str());
+
+	std::string output;
+	if (!make_folder(base) || !make_tree(folder, largeFile)) {
+		run("rm -rf " + quoted(base), output);
+		return 1;
+	}
+
+	// The image of IsoWriter is gone before mkisofs builds its own
+	IsoWriter writer;
+	writer.SetVolumeName(kVolumeName);
+	status_t status = writer.Build(folder.c_str(), image.c_str());
+	std::string written[3];
+	if (status != B_OK)
+		fail("IsoWriter couldn't build the image", strerror(status));
+	else {
+		check_description(image, writer.CountSectors());
+		written[0] = listing("", image);
+		written[1] = listing("-J", image);
+		written[2] = listing("-R", image);
+	}
+	unlink(image.c_str());
+
+	uint32 sectors = mkisofs_size(folder);
+	if (status == B_OK && sectors != writer.CountSectors()) {
+		char text[64];
+		snprintf(text, sizeof(text), "  IsoWriter: %u\n  mkisofs:   %u",
+			(unsigned)writer.CountSectors(), (unsigned)sectors);
+		fail("The image has another size", text);
+	}
+
+	if (!run(std::string("mkisofs ") + kImageOptions + " -V " + kVolumeName
+			+ " -quiet -o " + quoted(image) + " " + quoted(folder)
+			+ " 2>/dev/null", output))
+		fail("mkisofs couldn't build the image");
+	else if (status == B_OK) {
+		compare_listings("isoinfo -l lists other files", written[0],
+			listing("", image));
+		compare_listings("isoinfo -J -l lists other files", written[1],
+			listing("-J", image));
+		compare_listings("isoinfo -R -l lists other files", written[2],
+			listing("-R", image));
+	}
+
+	run("rm -rf " + quoted(base), output);
+
+	if (sFailures > 0) {
+		fprintf(stderr, "%d checks failed\n", sFailures);
+		return 1;
+	}
+	printf("All checks passed\n");
+	return 0;
+}